@@ -32,7 +32,7 @@ bool ASTVisitorEx::visitFunction(Function *obj)
     SFOREACH_OBJLIST(Variable, ti->instantiations, iter) {
       Variable const *inst = iter.data();
       if (inst->templateInfo()->instantiatedFunctionBody()) {
-        visitFunctionInstantiation(inst->funcDefn);
+        visitFunctionInstantiation(inst->getFuncDefn());
       }
     }
   }
@@ -56,6 +56,7 @@ BaseLexer::BaseLexer(StringTable &s, char const *fname)
 
     nextLoc(SL_UNKNOWN),     // changed below
     curLine(1),
+    lineTableFile(NULL),     // changed below
 
     strtable(s),
     errors(0),
@@ -68,6 +69,8 @@ BaseLexer::BaseLexer(StringTable &s, char const *fname)
 
   loc = sourceLocManager->encodeBegin(fname);
   nextLoc = loc;
+
+  lineTableFile = LineTable::global().beginFile(fname, loc);
 }
 
 
@@ -87,6 +90,7 @@ BaseLexer::BaseLexer(StringTable &s, SourceLoc initLoc,
 
     nextLoc(initLoc),
     curLine(0),              // changed below
+    lineTableFile(NULL),
 
     strtable(s),
     errors(0),
@@ -11,6 +11,7 @@
 #define BASELEXER_H
 
 #include "lexer.yy.h"       // yyFlexLexer
+#include "line-table.h"     // LineTable
 
 #include "sm-iostream.h"    // istream
 #include "lexerint.h"       // LexerInterface
@@ -26,6 +27,10 @@ protected:  // data
   SourceLoc nextLoc;               // location of *next* token
   int curLine;                     // current line number; needed for #line directives
 
+  // (nullable serf) index being built for this file; NULL when
+  // scanning a string, or if the file is already indexed
+  LineTable::File *lineTableFile;
+
 public:     // data
   StringTable &strtable;           // string table
   int errors;                      // count of errors encountered
@@ -38,6 +43,9 @@ protected:  // funcs
   // advance source location
   void updLoc() {
     loc = nextLoc;                 // location of *this* token
+    if (lineTableFile) {
+      lineTableFile->noteText(nextLoc, yym_text(), yym_leng());
+    }
     nextLoc = advText(nextLoc, yym_text(), yym_leng());
   }
 
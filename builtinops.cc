@@ -4,7 +4,9 @@
 #include "builtinops.h"    // this module
 #include "cc-type.h"       // Type, etc.
 #include "cc-env.h"        // Env
-#include "overload.h"      // getConversionOperators, OverloadResolver
+#include "overload.h"      // getConversionOperators, ArgumentInfo
+
+#include "sm-stdint.h"     // uintptr_t
 
 
 // ------------------ CandidateSet -----------------
@@ -18,10 +20,10 @@ PolymorphicCandidateSet::PolymorphicCandidateSet(Variable *v)
 {}
 
 void PolymorphicCandidateSet::instantiateBinary(Env &env,
-  OverloadResolver &resolver, OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
+  BuiltinCandidateList &dest, OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
 {
   // polymorphic candidates are easy
-  resolver.processCandidate(poly);
+  dest.push_back(BuiltinCandidate(poly, false /*ambiguous*/));
 }
 
 
@@ -97,7 +99,7 @@ void getConversionOperatorResults(Env &env, SObjList<Type> &dest,
 }
 
 void PredicateCandidateSet::instantiateBinary(Env &env,
-  OverloadResolver &resolver, OverloadableOp op,
+  BuiltinCandidateList &dest, OverloadableOp op,
   ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
 {
   // for this to overflow, I'd have to do 2^31 instantiations in a
@@ -149,7 +151,7 @@ void PredicateCandidateSet::instantiateBinary(Env &env,
       bool wasAmbig;
       Type *lub = computeLUB(env, lhsRet, rhsRet, wasAmbig);
       if (wasAmbig) {
-        addAmbigCandidate(env, resolver, op);
+        addAmbigCandidate(env, dest, op);
       }
       else {
         if (!lub) {
@@ -165,7 +167,7 @@ void PredicateCandidateSet::instantiateBinary(Env &env,
 
         if (lub && post(lub)) {
           // instantiate with this type
-          instantiateCandidate(env, resolver, op, lub);
+          instantiateCandidate(env, dest, op, lub);
         }
       }
     }
@@ -174,7 +176,7 @@ void PredicateCandidateSet::instantiateBinary(Env &env,
 
 
 void PredicateCandidateSet::instantiateCandidate(Env &env,
-  OverloadResolver &resolver, OverloadableOp op, Type *T)
+  BuiltinCandidateList &dest, OverloadableOp op, Type *T)
 {
   // have we already built an instantiated candidate?
   Inst *ic = instantiations.get(T);
@@ -200,7 +202,7 @@ void PredicateCandidateSet::instantiateCandidate(Env &env,
 
   // give it to the resolver
   ic->generation = generation;
-  resolver.processCandidate(ic->inst);
+  dest.push_back(BuiltinCandidate(ic->inst, false /*ambiguous*/));
 }
 
 
@@ -232,7 +234,7 @@ Variable *PredicateCandidateSet::makeNewCandidate(Env &env,
 //
 // I defer to the overload module to make such a candidate; here I
 // just say what I want.
-void PredicateCandidateSet::addAmbigCandidate(Env &env, OverloadResolver &resolver,
+void PredicateCandidateSet::addAmbigCandidate(Env &env, BuiltinCandidateList &dest,
   OverloadableOp op)
 {
   // it doesn't matter if I give this to the resolver more than once,
@@ -242,7 +244,7 @@ void PredicateCandidateSet::addAmbigCandidate(Env &env, OverloadResolver &resolv
     Type *t_void = env.getSimpleType(ST_VOID);
     ambigInst = env.createBuiltinBinaryOp(t_void, op, t_void, t_void);
   }
-  resolver.addAmbiguousBinaryCandidate(ambigInst);
+  dest.push_back(BuiltinCandidate(ambigInst, true /*ambiguous*/));
 }
 
 
@@ -260,7 +262,7 @@ AssignmentCandidateSet::AssignmentCandidateSet(SimpleTypeId retId, PreFilter r,
 
 
 void AssignmentCandidateSet::instantiateBinary(Env &env,
-  OverloadResolver &resolver, OverloadableOp op,
+  BuiltinCandidateList &dest, OverloadableOp op,
   ArgumentInfo &lhsInfo, ArgumentInfo &/*rhsInfo*/)
 {
   generation++;
@@ -286,7 +288,7 @@ void AssignmentCandidateSet::instantiateBinary(Env &env,
     // instantiate with the types to which the LHS convert, to
     // get a complete set (i.e. no additional instantiations
     // would change the answer)
-    instantiateCandidate(env, resolver, op, lhsRet);
+    instantiateCandidate(env, dest, op, lhsRet);
   }
 }
 
@@ -350,7 +352,7 @@ ArrowStarCandidateSet::~ArrowStarCandidateSet()
 //   CV12 T& operator->* (CV1 C1 *, CV2 T C2::*);
 // by finding instantiation pairs (C1,C2)
 void ArrowStarCandidateSet::instantiateBinary(Env &env,
-  OverloadResolver &resolver, OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
+  BuiltinCandidateList &dest, OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
 {
   xassert(op == OP_ARROW_STAR);
   generation++;
@@ -410,7 +412,7 @@ void ArrowStarCandidateSet::instantiateBinary(Env &env,
       Type *lhsParam = env.tfac.setQualifiers(SL_UNKNOWN, CV_NONE, lhsRet, NULL /*syntax*/);
       Type *rhsParam = env.tfac.setQualifiers(SL_UNKNOWN, CV_NONE, rhsRet, NULL /*syntax*/);
 
-      instantiateCandidate(env, resolver, lhsParam, rhsParam);
+      instantiateCandidate(env, dest, lhsParam, rhsParam);
     }
   }
 }
@@ -424,7 +426,7 @@ string ArrowStarCandidateSet::TypePair::asString() const
 
 // based on PredicateCandidateSet::instantiateCandidate
 void ArrowStarCandidateSet::instantiateCandidate(Env &env,
-  OverloadResolver &resolver, Type *lhsType, Type *rhsType)
+  BuiltinCandidateList &dest, Type *lhsType, Type *rhsType)
 {
   TypePair pair(lhsType, rhsType);
 
@@ -464,7 +466,169 @@ void ArrowStarCandidateSet::instantiateCandidate(Env &env,
 
   // give it to the resolver
   ic->generation = generation;
-  resolver.processCandidate(ic->inst);
+  dest.push_back(BuiltinCandidate(ic->inst, false /*ambiguous*/));
+}
+
+
+// ------------------ BuiltinCandidateCache -----------------
+bool BuiltinCandidateCache::OperandKey::operator== (OperandKey const &obj) const
+{
+  return m_atomic == obj.m_atomic &&
+         m_cv == obj.m_cv &&
+         m_isReference == obj.m_isReference &&
+         m_special == obj.m_special;
+}
+
+unsigned BuiltinCandidateCache::OperandKey::hashValue() const
+{
+  return (unsigned)(uintptr_t)m_atomic * 31 +
+         ((unsigned)m_cv >> CV_SHIFT_AMOUNT) * 7 +
+         (m_isReference? 3 : 0) +
+         (unsigned)m_special;
+}
+
+bool BuiltinCandidateCache::Key::operator== (Key const &obj) const
+{
+  return m_op == obj.m_op &&
+         m_lhs == obj.m_lhs &&
+         m_rhs == obj.m_rhs;
+}
+
+size_t BuiltinCandidateCache::KeyHash::operator() (Key const &k) const
+{
+  return ((size_t)k.m_lhs.hashValue() * 1000 +
+          k.m_rhs.hashValue()) * NUM_OVERLOADABLE_OPS + k.m_op;
+}
+
+
+BuiltinCandidateCache::BuiltinCandidateCache()
+  : m_map(),
+    m_numQueries(0),
+    m_numHits(0),
+    m_numSkipped(0)
+{}
+
+BuiltinCandidateCache::~BuiltinCandidateCache()
+{}
+
+
+// True if 't' is a scalar type whose conversion behavior cannot
+// change as more of the translation unit is processed.
+static bool isFixedScalarType(Type const *t)
+{
+  t = t->asRvalC();
+  if (!t->isCVAtomicType()) {
+    return false;
+  }
+  AtomicType const *at = t->asCVAtomicTypeC()->atomic;
+  return at->isSimpleType() || at->isEnumType();
+}
+
+STATICDEF bool BuiltinCandidateCache::getOperandKey(OperandKey &key,
+  ArgumentInfo const &info)
+{
+  if (info.overloadSet.isNotEmpty() || !info.type) {
+    return false;
+  }
+
+  key.m_special = info.special;
+
+  Type const *t = info.type->asRvalC();
+  if (t->isCompoundType()) {
+    CompoundType const *ct = t->asCompoundTypeC();
+    if (!ct->hasFinishedDefinition()) {
+      return false;            // 'conversionOperators' is not final
+    }
+
+    // the conversion results are only fixed if they are scalars
+    SFOREACH_OBJLIST(Variable, ct->conversionOperators, iter) {
+      if (!isFixedScalarType(iter.data()->type->asFunctionTypeC()->retType)) {
+        return false;
+      }
+    }
+
+    // 'getConversionOperatorResults' only looks at the class
+    key.m_atomic = ct;
+    key.m_cv = CV_NONE;
+    key.m_isReference = false;
+    return true;
+  }
+
+  if (isFixedScalarType(t)) {
+    key.m_atomic = t->asCVAtomicTypeC()->atomic;
+    key.m_cv = t->getCVFlags();
+    key.m_isReference = info.type->isReference();
+    return true;
+  }
+
+  return false;
+}
+
+
+// Class operand with no way to convert to a non-class type.
+static bool cannotConvertToBuiltin(ArgumentInfo const &info)
+{
+  if (info.overloadSet.isNotEmpty() || !info.type) {
+    return false;
+  }
+
+  Type const *t = info.type->asRvalC();
+  return t->isCompoundType() &&
+         t->asCompoundTypeC()->conversionOperators.isEmpty();
+}
+
+
+BuiltinCandidateList const &BuiltinCandidateCache::getCandidates(
+  Env &env, OverloadableOp op,
+  ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo,
+  BuiltinCandidateList &scratch)
+{
+  m_numQueries++;
+
+  ObjArrayStack<CandidateSet> &builtins = env.builtinBinaryOperator[op];
+
+  if (cannotConvertToBuiltin(lhsInfo) && cannotConvertToBuiltin(rhsInfo)) {
+    // none of these are viable, but they are still reported as
+    // candidates in diagnostics
+    m_numSkipped++;
+    for (int i=0; i < builtins.length(); i++) {
+      if (builtins[i]->isPolymorphic()) {
+        builtins[i]->instantiateBinary(env, scratch, op, lhsInfo, rhsInfo);
+      }
+    }
+    return scratch;
+  }
+
+  Key key;
+  key.m_op = op;
+  bool cacheable = getOperandKey(key.m_lhs, lhsInfo) &&
+                   getOperandKey(key.m_rhs, rhsInfo);
+  if (cacheable) {
+    auto it = m_map.find(key);
+    if (it != m_map.end()) {
+      m_numHits++;
+      return it->second;
+    }
+  }
+
+  for (int i=0; i < builtins.length(); i++) {
+    builtins[i]->instantiateBinary(env, scratch, op, lhsInfo, rhsInfo);
+  }
+
+  if (cacheable) {
+    // entries are never removed, so the reference remains valid
+    // even if processing the candidates adds more entries
+    return m_map[key] = scratch;
+  }
+  return scratch;
+}
+
+
+void BuiltinCandidateCache::printStats(ostream &os) const
+{
+  os << "built-in operator candidate queries: " << m_numQueries << "\n"
+     << "built-in operator candidate hits: " << m_numHits << "\n"
+     << "built-in operator candidates skipped: " << m_numSkipped << "\n";
 }
 
 
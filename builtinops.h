@@ -5,12 +5,37 @@
 #define BUILTINOPS_H
 
 #include "cc-env-fwd.h"    // Env
-#include "cc-type-fwd.h"   // Type
+#include "cc-type-fwd.h"   // Type, AtomicType
 #include "cc-flags.h"      // BinaryOp
 #include "okhashtbl.h"     // OwnerKHashTable
-#include "overload-fwd.h"  // OverloadResolver, ArgumentInfo
+#include "overload-fwd.h"  // ArgumentInfo
 #include "variable-fwd.h"  // Variable
 
+#include "sm-ostream.h"    // ostream
+
+#include <unordered_map>   // std::unordered_map
+#include <vector>          // std::vector
+
+
+// one candidate produced by 'CandidateSet::instantiateBinary'
+class BuiltinCandidate {
+public:      // data
+  Variable *m_var;         // (serf)
+
+  // true if 'm_var' is the placeholder for an ambiguous LUB, to be
+  // given to 'OverloadResolver::addAmbiguousBinaryCandidate'
+  bool m_ambiguous;
+
+public:      // funcs
+  BuiltinCandidate(Variable *v, bool a)
+    : m_var(v),
+      m_ambiguous(a)
+  {}
+};
+
+// candidates in the order overload resolution should see them
+typedef std::vector<BuiltinCandidate> BuiltinCandidateList;
+
 
 // a set of candidates, usually one line of 13.6; since many of the
 // sets in 13.6 are infinite, and the finite ones are large, the
@@ -21,9 +46,13 @@ public:      // funcs
   virtual ~CandidateSet();
 
   // instantiate the pattern as many times as necessary, given the
-  // argument types 'lhsType' and 'rhsType'
-  virtual void instantiateBinary(Env &env, OverloadResolver &resolver,
+  // argument types 'lhsType' and 'rhsType', appending the results
+  // to 'dest'
+  virtual void instantiateBinary(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)=0;
+
+  // true if the set is a single candidate, independent of the operands
+  virtual bool isPolymorphic() const { return false; }
 };
 
 
@@ -36,8 +65,9 @@ public:      // data
 public:      // funcs
   PolymorphicCandidateSet(Variable *v);
 
-  virtual void instantiateBinary(Env &env, OverloadResolver &resolver,
+  virtual void instantiateBinary(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo) override;
+  virtual bool isPolymorphic() const override { return true; }
 };
 
 
@@ -106,8 +136,8 @@ protected:   // data
 
 protected:   // funcs
   void instantiateCandidate(Env &env,
-    OverloadResolver &resolver, OverloadableOp op, Type *T);
-  void addAmbigCandidate(Env &env, OverloadResolver &resolver,
+    BuiltinCandidateList &dest, OverloadableOp op, Type *T);
+  void addAmbigCandidate(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op);
 
   virtual Variable *makeNewCandidate(Env &env, OverloadableOp op, Type *T);
@@ -116,7 +146,7 @@ public:      // funcs
   PredicateCandidateSet(SimpleTypeId retId, PreFilter pre, PostFilter post);
   ~PredicateCandidateSet();
 
-  virtual void instantiateBinary(Env &env, OverloadResolver &resolver,
+  virtual void instantiateBinary(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo) override;
 };
 
@@ -129,7 +159,7 @@ protected:   // funcs
 public:      // funcs
   AssignmentCandidateSet(SimpleTypeId retId, PreFilter pre, PostFilter post);
 
-  virtual void instantiateBinary(Env &env, OverloadResolver &resolver,
+  virtual void instantiateBinary(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo) override;
 };
 
@@ -184,17 +214,90 @@ private:    // data
 
 private:    // funcs
   void instantiateCandidate(Env &env,
-    OverloadResolver &resolver, Type *lhsType, Type *rhsType);
+    BuiltinCandidateList &dest, Type *lhsType, Type *rhsType);
 
 public:     // funcs
   ArrowStarCandidateSet();
   ~ArrowStarCandidateSet();
 
-  virtual void instantiateBinary(Env &env, OverloadResolver &resolver,
+  virtual void instantiateBinary(Env &env, BuiltinCandidateList &dest,
     OverloadableOp op, ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo) override;
 };
 
 
+// Memo of the built-in candidates for binary operators, keyed by the
+// operator and, for each operand, the set of types it can be
+// converted to: for a class, its conversion operators, and for
+// anything else, the operand type itself.  Entries are only made
+// when those sets are final and cannot involve classes (whose
+// hierarchy might still change), so they never need invalidation.
+class BuiltinCandidateCache {
+private:     // types
+  // what matters about one operand
+  class OperandKey {
+  public:
+    // class, or atomic of a scalar operand type
+    AtomicType const *m_atomic;
+
+    // for scalar operands, cv-flags of the type and whether it is
+    // a reference; these affect the para 19/20 filters
+    CVFlags m_cv;
+    bool m_isReference;
+
+    // affects the null pointer relaxation of the LUB rules
+    SpecialExpr m_special;
+
+  public:
+    bool operator== (OperandKey const &obj) const;
+    unsigned hashValue() const;
+  };
+
+  class Key {
+  public:
+    OverloadableOp m_op;
+    OperandKey m_lhs;
+    OperandKey m_rhs;
+
+  public:
+    bool operator== (Key const &obj) const;
+  };
+
+  class KeyHash {
+  public:
+    size_t operator() (Key const &k) const;
+  };
+
+private:     // data
+  std::unordered_map<Key, BuiltinCandidateList, KeyHash> m_map;
+
+  // statistics
+  unsigned m_numQueries;
+  unsigned m_numHits;
+  unsigned m_numSkipped;
+
+private:     // funcs
+  static bool getOperandKey(OperandKey &key, ArgumentInfo const &info);
+
+public:      // funcs
+  BuiltinCandidateCache();
+  ~BuiltinCandidateCache();
+
+  // Return the candidates from 'env.builtinBinaryOperator[op]' for
+  // the given operands.  If they cannot be cached, they are computed
+  // into 'scratch', which is then returned.
+  //
+  // When neither operand can be converted to a built-in type (both
+  // are of class types without conversion operators), the sets that
+  // are built from the conversion results would yield nothing, so
+  // only the polymorphic ones are consulted.
+  BuiltinCandidateList const &getCandidates(Env &env, OverloadableOp op,
+    ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo,
+    BuiltinCandidateList &scratch);
+
+  void printStats(ostream &os) const;
+};
+
+
 // some pre filters
 Type *rvalFilter(Type *t, bool);
 Type *rvalIsPointer(Type *t, bool);
@@ -4,6 +4,7 @@
 #include "strutil.h"        // plural
 #include "generic_aux.h"    // C++ AST, and genericPrintAmbiguities, etc.
 #include "cc-ast-aux.h"     // class LoweredASTVisitor
+#include "line-table.h"     // decodeSourceLoc
 
 
 // ---------------------- LoweredASTVisitorHelper ----------------------
@@ -12,8 +13,8 @@ void LoweredASTVisitorHelper::oneTempl(Variable *var0) {
   xassert(var0->templateInfo());
 
   // run a sub-traversal of the AST instantiation
-  if (var0->funcDefn) {
-    var0->funcDefn->traverse(loweredVisitor);
+  if (var0->getFuncDefn()) {
+    var0->getFuncDefn()->traverse(loweredVisitor);
   }
   if (var0->type->isCompoundType() && var0->type->asCompoundType()->syntax) {
     var0->type->asCompoundType()->syntax->traverse(loweredVisitor);
@@ -442,9 +443,9 @@ void Function::printExtras(ostream &os, int indent) const
       string label = stringc << "instantiation[" << ct++ << "]: "
                              << inst->templateInfo()->templateName();
 
-      if (inst->funcDefn) {
+      if (inst->getFuncDefn()) {
         label = stringc << label << " (defn)";
-        inst->funcDefn->debugPrint(os, indent+2, label.c_str());
+        inst->getFuncDefn()->debugPrint(os, indent+2, label.c_str());
       }
       else {
         ind(os, indent+2) << label << " (decl) = " << inst->toString() << "\n";
@@ -1095,7 +1096,7 @@ string Statement::lineColString() const
 {
   char const *fname;
   int line, col;
-  sourceLocManager->decodeLineCol(loc, fname, line, col);
+  decodeSourceLoc(loc, fname, line, col);
 
   return stringc << line << ":" << col;
 }
@@ -181,7 +181,7 @@ Function *ElabVisitor::makeFunction(SourceLoc loc, Variable *var,
 
   // the existence of a definition has implications for the Variable too
   var->setFlag(DF_DEFINITION);
-  var->funcDefn = f;
+  var->setFuncDefn(f);
 
   return f;
 }
@@ -8,16 +8,19 @@
 #include "cc-flags.h"                  // getBooleanOperatorResultSimpleTypeId, etc.
 #include "cc-lang.h"                   // CCLang
 #include "implconv.h"                  // ImplicitConversion
+#include "line-table.h"                // LineTable, sourceLocString
 #include "mtype.h"                     // MType
 #include "overload.h"                  // OVERLOADTRACE
+#include "template.h"                  // TemplateArgumentListTable
 
 // smbase
+#include "sm-stdint.h"                 // uintptr_t
 #include "string-util.h"               // join, doubleQuote, beginsWith
 #include "strtable.h"                  // StringTable
 #include "trace.h"                     // tracingSys
 
 // libc++
-#include <algorithm>                   // std::max, std::sort
+#include <algorithm>                   // std::max, std::sort, std::find, std::reverse
 #include <map>                         // std::map
 #include <string>                      // std::string
 #include <vector>                      // std::vector
@@ -316,8 +319,32 @@ Env::Env(StringTable &s, CCLang &L, TypeFactory &tf,
     env(*this),
     unit(unit0),
     scopes(),
+    m_scopeFrames(),
     disambiguateOnly(false),
     ctorFinished(false),
+    m_typeEqualityCache(1 << 16),          // enough for large system headers
+    m_resolvedDQTs(),
+    m_numDQTQueries(0),
+    m_numDQTHits(0),
+    m_numDQTFlushes(0),
+    m_associatedScopeLists(),
+    m_typeAssociatedScopes(),
+    m_argDepLookups(),
+    m_assocScratch(),
+    m_assocSortScratch(),
+    m_numAssocScopeQueries(0),
+    m_numAssocScopeHits(0),
+    m_numArgDepLookups(0),
+    m_numArgDepLookupHits(0),
+    m_numArgDepLookupFlushes(0),
+    m_qualifierLookups(),
+    m_numQualifierLookups(0),
+    m_numQualifierLookupHits(0),
+    m_numSharedDefaultArgs(0),
+    m_numDefaultArgCopies(0),
+    m_numOverloadIndexLookups(0),
+    m_numOverloadIndexSkipped(0),
+    m_builtinCandidateCache(),
 
     disambiguationNestingLevel(0),
     checkFunctionBodies(true),
@@ -382,6 +409,9 @@ Env::Env(StringTable &s, CCLang &L, TypeFactory &tf,
 
     // builtin{Un,Bin}aryOperator[] start as arrays of empty
     // arrays, and then have things added to them below
+    m_candidatePool(new CandidatePool),
+    m_conversionOperatorCache(new ConversionOperatorCache),
+    m_overloadStats(tracingSys("overloadStats")? new OverloadStats : NULL),
 
     // (in/t0568.cc) apparently GCC and ICC always delay, so Elsa will
     // too, even though I think that the only programs for which eager
@@ -399,6 +429,8 @@ Env::Env(StringTable &s, CCLang &L, TypeFactory &tf,
 
     collectLookupResults("")
 {
+  m_typeEqualityCache.activate();
+
   // create first scope
   SourceLoc emptyLoc = SL_UNKNOWN;
   {
@@ -412,13 +444,13 @@ Env::Env(StringTable &s, CCLang &L, TypeFactory &tf,
     // for, so it doesn't help to have it in Oink
     unit->globalScope = s;
 
-    scopes.prepend(s);
+    pushScope(s);
     s->openedScope(*this);
 
     // make a Variable for it
     globalScopeVar = makeVariable(SL_INIT, str("<globalScope>"),
                                   NULL /*type*/, DF_NAMESPACE);
-    globalScopeVar->m_denotedScope = s;
+    globalScopeVar->setNamespaceScope(s);
     s->namespaceVar = globalScopeVar;
   }
 
@@ -966,10 +998,12 @@ void Env::setupOperatorOverloading()
 
 Env::~Env()
 {
+  m_typeEqualityCache.deactivate();
+
   // delete the scopes one by one, so we can skip any
   // which are in fact not owned
   while (scopes.isNotEmpty()) {
-    Scope *s = scopes.removeFirst();
+    Scope *s = popScope();
     s->closedScope();
     if (s->curCompound || s->namespaceVar || s->isGlobalScope()) {
       // this isn't one we own
@@ -983,6 +1017,11 @@ Env::~Env()
   }
 
   delete dependentScope;
+
+  for (AssociatedScopes *list : m_associatedScopeLists) {
+    delete[] list->m_scopes;
+    delete list;
+  }
 }
 
 
@@ -1299,13 +1338,59 @@ Scope *Env::createScope(ScopeKind sk)
 }
 
 
+void Env::pushScope(Scope *s)
+{
+  scopes.prepend(s);
+  pushScopeFrame(s);
+}
+
+
+Scope *Env::popScope()
+{
+  Scope *s = scopes.removeFirst();
+  xassert(m_scopeFrames.back().m_scope == s);
+  m_scopeFrames.pop_back();
+  return s;
+}
+
+
+void Env::pushScopeFrame(Scope *s)
+{
+  int index = (int)m_scopeFrames.size();
+
+  ScopeFrame frame;
+  if (index == 0) {
+    for (int k=0; k < NUM_SCOPEKINDS; k++) {
+      frame.m_nearestOfKind[k] = -1;
+    }
+    frame.m_nearestOuter = -1;
+    frame.m_nearestNonTemplate = -1;
+  }
+  else {
+    frame = m_scopeFrames.back();
+  }
+  frame.m_scope = s;
+
+  frame.m_nearestOfKind[s->scopeKind] = index;
+  if (!s->isTemplateScope()) {
+    frame.m_nearestNonTemplate = index;
+
+    if (!s->isClassScope() && !s->isParameterScope()) {
+      frame.m_nearestOuter = index;
+    }
+  }
+
+  m_scopeFrames.push_back(frame);
+}
+
+
 Scope *Env::enterScope(ScopeKind sk, char const *forWhat)
 {
   // propagate the 'curFunction' field
   Function *f = scopes.first()->curFunction;
   Scope *newScope = createScope(sk);
   setParentScope(newScope);
-  scopes.prepend(newScope);
+  pushScope(newScope);
   newScope->curFunction = f;
 
   TRACE("scope", locStr() << ": entered " << newScope->desc() << " for " << forWhat);
@@ -1335,7 +1420,7 @@ void Env::exitScope(Scope *s)
   s->closedScope();
 
   TRACE("scope", locStr() << ": exited " << s->desc());
-  Scope *f = scopes.removeFirst();
+  Scope *f = popScope();
   xassert(s == f);
   delete f;
 }
@@ -1346,8 +1431,9 @@ void Env::extendScope(Scope *s)
   TRACE("scope", locStr() << ": extending " << s->desc());
 
   Scope *prevScope = scope();
-  scopes.prepend(s);
+  pushScope(s);
   s->curLoc = prevScope->curLoc;
+  classScopesChanged(s);
 
   s->openedScope(*this);
 }
@@ -1375,9 +1461,20 @@ void Env::retractScope(Scope *s)
 
   s->closedScope();
 
-  Scope *first = scopes.removeFirst();
+  Scope *first = popScope();
   xassert(first == s);
   // we don't own 's', so don't delete it
+
+  classScopesChanged(s);
+}
+
+
+void Env::classScopesChanged(Scope *s)
+{
+  if (s->curCompound && !m_resolvedDQTs.empty()) {
+    m_resolvedDQTs.clear();
+    m_numDQTFlushes++;
+  }
 }
 
 
@@ -1400,7 +1497,7 @@ void Env::gdbScopes()
 
       Variable *value = iter.value();
       if (value->isNamespace()) {
-        cout << "  " << iter.key() << ": " << value->m_denotedScope->desc() << endl;
+        cout << "  " << iter.key() << ": " << value->getDenotedScope()->desc() << endl;
       }
       else {
         cout << "  " << iter.key()
@@ -1419,6 +1516,40 @@ void Env::gdbScopes()
 }
 
 
+void Env::printCacheStats(ostream &os) const
+{
+  tfac.templateArgumentLists().printStats(os);
+  ClassLayout::printStats(os);
+  os << "class hierarchy indices built: "
+     << ClassHierarchyIndex::s_numBuilt << "\n";
+  m_typeEqualityCache.printStats(os);
+  os << "DQT resolution queries: " << m_numDQTQueries << "\n"
+     << "DQT resolution hits: " << m_numDQTHits << "\n"
+     << "DQT resolution cache flushes: " << m_numDQTFlushes << "\n";
+  m_builtinCandidateCache.printStats(os);
+  m_conversionOperatorCache->printStats(os);
+  os << "associated scope queries: " << m_numAssocScopeQueries << "\n"
+     << "associated scope hits: " << m_numAssocScopeHits << "\n"
+     << "arg-dep lookups: " << m_numArgDepLookups << "\n"
+     << "arg-dep lookup hits: " << m_numArgDepLookupHits << "\n"
+     << "arg-dep lookup cache flushes: " << m_numArgDepLookupFlushes << "\n"
+     << "qualifier lookups: " << m_numQualifierLookups << "\n"
+     << "qualifier lookup hits: " << m_numQualifierLookupHits << "\n"
+     << "shared default args: " << m_numSharedDefaultArgs << "\n"
+     << "default args copied for tcheck: " << m_numDefaultArgCopies << "\n"
+     << "indexed overload set lookups: " << m_numOverloadIndexLookups << "\n"
+     << "overload set members skipped: " << m_numOverloadIndexSkipped << "\n"
+     << "using closure queries: " << Scope::s_numUsingClosureQueries << "\n"
+     << "using closure computations: "
+       << Scope::s_numUsingClosureComputations << "\n"
+     << "using-edge fast lookups: " << Scope::s_numUsingEdgeFastLookups << "\n"
+     << "variables: " << Variable::numVariables
+       << " (" << sizeof(Variable) << " bytes each)\n"
+     << "variables with cold fields: " << Variable::numColdFields << "\n";
+  LineTable::global().printStats(os);
+}
+
+
 // this should be a rare event
 void Env::refreshScopeOpeningEffects()
 {
@@ -1482,7 +1613,7 @@ string Env::locationStackString() const
   stringBuilder sb;
 
   FOREACH_OBJLIST(Scope, scopes, iter) {
-    sb << "  " << toString(iter.data()->curLoc) << "\n";
+    sb << "  " << sourceLocString(iter.data()->curLoc) << "\n";
   }
 
   return sb;
@@ -1498,7 +1629,7 @@ string Env::instLocStackString() const
   else {
     stringBuilder sb;
     for (int i = instantiationLocStack.length()-1; i >= 0; i--) {
-      sb << " (inst from " << instantiationLocStack[i] << ")";
+      sb << " (inst from " << sourceLocString(instantiationLocStack[i]) << ")";
     }
 
     return sb;
@@ -1535,19 +1666,12 @@ Scope *Env::acceptingScope(DeclFlags df)
 
 Scope *Env::outerScope()
 {
-  FOREACH_OBJLIST_NC(Scope, scopes, iter) {
-    Scope *s = iter.data();
-    if (s->isTemplateScope() ||              // skip template scopes
-        s->isClassScope() ||                 // skip class scopes
-        s->isParameterScope()) {             // skip parameter list scopes
-      continue;
-    }
-
-    return s;
+  // skip template, class and parameter list scopes
+  Scope *s = frameScope(m_scopeFrames.back().m_nearestOuter);
+  if (!s) {
+    xfailure("couldn't find the outer scope!");
   }
-
-  xfailure("couldn't find the outer scope!");
-  return NULL;    // silence warning
+  return s;
 }
 
 
@@ -1578,28 +1702,24 @@ Scope *Env::enclosingKindScope(ScopeKind k)
 
 Scope *Env::enclosingKindScopeAbove(ScopeKind k, Scope *s)
 {
-  FOREACH_OBJLIST_NC(Scope, scopes, iter) {
-    if (s) {
-      if (iter.data() == s) {
-        // found the scope we want to look above
-        s = NULL;
-      }
-      else {
-        // still looking for 's'
-      }
-      continue;
-    }
+  // index of the innermost entry to consider
+  int start = (int)m_scopeFrames.size() - 1;
 
-    if (iter.data()->scopeKind == k) {
-      return iter.data();
+  if (s) {
+    // find the scope we want to look above
+    while (start >= 0 && m_scopeFrames[start].m_scope != s) {
+      start--;
     }
+    if (start < 0) {
+      xfailure("did not find scope above which we wanted to look");
+    }
+    start--;
   }
 
-  if (s) {
-    xfailure("did not find scope above which we wanted to look");
+  if (start < 0) {
+    return NULL;
   }
-
-  return NULL;    // not found
+  return frameScope(m_scopeFrames[start].m_nearestOfKind[k]);
 }
 
 
@@ -1617,13 +1737,10 @@ CompoundType *Env::enclosingClassScope()
 
 Scope *Env::nonTemplateScope()
 {
-  ObjListIterNC<Scope> iter(scopes);
-  while (iter.data()->scopeKind == SK_TEMPLATE_PARAMS ||
-         iter.data()->scopeKind == SK_TEMPLATE_ARGS) {
-    iter.adv();
-  }
-
-  return iter.data();
+  // skip SK_TEMPLATE_PARAMS and SK_TEMPLATE_ARGS scopes
+  Scope *s = frameScope(m_scopeFrames.back().m_nearestNonTemplate);
+  xassert(s);
+  return s;
 }
 
 bool Env::currentScopeAboveTemplEncloses(Scope const *s)
@@ -1881,6 +1998,11 @@ Scope *Env::lookupOneQualifier(
 }
 
 
+static string cannotFindScopeNameText(StringRef qual)
+{
+  return stringc << "cannot find scope name '" << qual << "'";
+}
+
 // lookup just the name part of a qualifier; template arguments
 // (if any) are dealt with later
 Variable *Env::lookupOneQualifier_bareName(
@@ -1924,9 +2046,7 @@ Variable *Env::lookupOneQualifier_bareName(
       //
       // alternatively, I could just re-traverse the original name;
       // I'm lazy for now
-      error(stringc
-        << "cannot find scope name '" << qual << "'",
-        EF_DISAMBIGUATES);
+      error(loc(), &cannotFindScopeNameText, qual, EF_DISAMBIGUATES);
     }
     return NULL;
   }
@@ -2093,8 +2213,9 @@ Scope *Env::lookupOneQualifier_useArgs(
     }
 
     // the namespace becomes the active scope
-    xassert(qualVar->m_denotedScope);
-    return qualVar->m_denotedScope;
+    Scope *ret = qualVar->getDenotedScope();
+    xassert(ret);
+    return ret;
   }
 }
 
@@ -2763,7 +2884,7 @@ Type *Env::type_info_const_ref()
   Variable *stdNS = scope->lookupVariable(str("std"), *this);
   if (stdNS && stdNS->isNamespace()) {
     // use that instead of the global scope
-    scope = stdNS->m_denotedScope;
+    scope = stdNS->getDenotedScope();
   }
 
   // look for 'type_info'
@@ -3103,28 +3224,49 @@ Variable *Env::lookupVariableForDeclaration
 Variable *Env::findInOverloadSet(OverloadSet *oset,
                                  FunctionType *ft, CVFlags receiverCV)
 {
-  SFOREACH_OBJLIST_NC(Variable, oset->set, iter) {
-    FunctionType *iterft = iter.data()->type->asFunctionType();
+  // check the parameters other than '__receiver'
+  MatchFlags mflags = MF_STAT_EQ_NONSTAT | MF_IGNORE_IMPLICIT;
 
-    // check the parameters other than '__receiver'
-    MatchFlags mflags = MF_STAT_EQ_NONSTAT | MF_IGNORE_IMPLICIT;
+  if (inUninstTemplate()) {
+    // do not check the return types; we can diagnose a mismatch
+    // when the template is instantiated, and it is sometimes
+    // hard to tell when they match (in/t0290.cc)
+    mflags |= MF_IGNORE_RETURN;
+  }
 
-    if (inUninstTemplate()) {
-      // do not check the return types; we can diagnose a mismatch
-      // when the template is instantiated, and it is sometimes
-      // hard to tell when they match (in/t0290.cc)
-      mflags |= MF_IGNORE_RETURN;
-    }
+  auto isMatch = [this, ft, receiverCV, mflags](Variable *v) -> bool {
+    FunctionType *iterft = v->type->asFunctionType();
 
     if (!equivalentTypes(iterft, ft, mflags)) {
-      continue;    // not the one we want
+      return false;    // not the one we want
     }
 
     // if 'this' exists, it must match 'receiverCV'
-    if (iterft->getReceiverCV() != receiverCV) continue;
+    return iterft->getReceiverCV() == receiverCV;
+  };
+
+  // large sets are indexed by signature, so only the members that
+  // might match need to be compared
+  OverloadSet::CandidateIter candIter(*oset, ft);
+  if (candIter.isIndexed()) {
+    m_numOverloadIndexLookups++;
+    Variable *ret = NULL;
+    int compared = 0;
+    for (; !ret && !candIter.isDone(); candIter.adv()) {
+      compared++;
+      if (isMatch(candIter.data())) {
+        ret = candIter.data();
+      }
+    }
+    m_numOverloadIndexSkipped += oset->count() - compared;
+    return ret;
+  }
 
-    // ok, this is the right one
-    return iter.data();
+  SFOREACH_OBJLIST_NC(Variable, oset->set, iter) {
+    if (isMatch(iter.data())) {
+      // ok, this is the right one
+      return iter.data();
+    }
   }
   return NULL;    // not found
 }
@@ -3181,6 +3323,24 @@ bool containsUnassociatedTemplateParams(Type *t)
 // those that have not are regarded as arbitrary type variables, and
 // therefore subject to unification by MType.
 bool Env::equivalentTypes(Type const *a, Type const *b, MatchFlags mflags)
+{
+  TypeEqualityCache &cache = m_typeEqualityCache;
+  bool cacheable, result;
+  if (cache.lookup(a, b, mflags, TypeEqualityCache::K_EQUIVALENT_TYPES,
+                   cacheable, result)) {
+    return result;
+  }
+
+  result = equivalentTypes_uncached(a, b, mflags);
+
+  if (cacheable) {
+    cache.insert(a, b, mflags, TypeEqualityCache::K_EQUIVALENT_TYPES, result);
+  }
+  return result;
+}
+
+bool Env::equivalentTypes_uncached(Type const *a, Type const *b,
+                                   MatchFlags mflags)
 {
   // the 'a' type refers to the already-existing function template
   // declaration, wherein the parameters *have* been associated, and
@@ -3457,8 +3617,12 @@ Variable *Env::createDeclaration(
           // name remains unchanged
           prior->type = type;
           prior->setFlagsTo(dflags);
-          prior->funcDefn = NULL;
-          // overload can stay the same
+          prior->setFuncDefn(NULL);
+          // overload can stay the same, but its index must learn
+          // about the new type
+          if (prior->overload) {
+            prior->overload->memberTypeChanged(prior);
+          }
           prior->setUsingAlias(NULL);
           scope->registerVariable(prior);
           return prior;
@@ -3593,6 +3757,9 @@ Variable *Env::createDeclaration(
           prior->type->asFunctionType()->flags |= FF_VARARGS;
         }
 
+        // both types may now compare differently
+        m_typeEqualityCache.invalidate();
+
         // 10/08/04: In C, the rules for function type declaration
         // compatibility are more complicated, relying on "default
         // argument promotions", a determination of whether the
@@ -3702,6 +3869,7 @@ Variable *Env::createDeclaration(
     if (prior->type->isArrayType()
         && prior->type->asArrayType()->size == ArrayType::NO_SIZE) {
       prior->type->asArrayType()->size = type->asArrayType()->size;
+      m_typeEqualityCache.invalidate();
     }
 
     // prior is a ptr to the previous decl/def var; type is the
@@ -4053,6 +4221,9 @@ void Env::pushDeclarationScopes(Variable *v, Scope *stop)
   ObjListMutator<Scope> mut(scopes);
   Scope *s = v->m_containingScope;
 
+  // scopes inserted, innermost first
+  ArrayStack<Scope*> inserted;
+
   while (s != stop) {
     // put in a piece of 'extendScope'; I can't call that directly
     // because it would put things in the wrong order
@@ -4061,12 +4232,20 @@ void Env::pushDeclarationScopes(Variable *v, Scope *stop)
 
     mut.insertBefore(s);     // insert 's' before where 'mut' points
     mut.adv();               // advance 'mut' past 's', so it points at orig obj
+    inserted.push(s);
+    classScopesChanged(s);
     s = s->parentScope;
     if (!s) {
       // 'v->m_containingScope' must not have been inside 'stop'
       xfailure("pushDeclarationScopes: missed 'stop' scope");
     }
   }
+
+  // the inserted scopes are now the innermost ones, so they go at the
+  // end of 'm_scopeFrames', outermost first
+  for (int i = inserted.length()-1; i >= 0; i--) {
+    pushScopeFrame(inserted[i]);
+  }
 }
 
 // undo the effects of 'pushDeclarationScopes'
@@ -4150,9 +4329,10 @@ void Env::removeScopesInside(ObjList<Scope> &dest, Scope *bound)
 {
   xassert(bound);
   while (scopes.first() != bound) {
-    Scope *s = scopes.removeFirst();
+    Scope *s = popScope();
     TRACE("scope", "temporarily removing " << s->desc());
     dest.prepend(s);
+    classScopesChanged(s);
   }
 }
 
@@ -4163,7 +4343,8 @@ void Env::restoreScopesInside(ObjList<Scope> &src, Scope *bound)
   while (src.isNotEmpty()) {
     Scope *s = src.removeFirst();
     TRACE("scope", "restoring " << s->desc());
-    scopes.prepend(s);
+    pushScope(s);
+    classScopesChanged(s);
   }
 }
 
@@ -4376,132 +4557,165 @@ bool Env::possiblySetOverloadedFunctionVar(Expression *expr, Type *paramType,
 }
 
 
-// get scopes associated with 'type'; C++98 3.4.2 para 2
-//
-// this could perhaps be made faster by using a hash table set
-void Env::getAssociatedScopes(SObjList<Scope> &associated, Type *type)
+// ------------------ argument-dependent lookup -------------------
+AssociatedScopes::AssociatedScopes(Scope * const *scopes, int count)
+  : m_scopes(scopes),
+    m_count(count),
+    m_hash(count)
 {
-  switch (type->getTag()) {
-    default:
-      xfailure("bad type tag");
+  for (int i=0; i < count; i++) {
+    m_hash = m_hash*31 + (size_t)(uintptr_t)scopes[i];
+  }
+}
 
-    case Type::T_ATOMIC: {
-      AtomicType *atomic = type->asCVAtomicType()->atomic;
-      switch (atomic->getTag()) {
-        default:
-          // other cases: nothing
-          return;
-
-        case AtomicType::T_SIMPLE:
-          // bullet 1: nothing
-          return;
-
-        case AtomicType::T_COMPOUND: {
-          CompoundType *ct = atomic->asCompoundType();
-          if (!ct->isInstantiation()) {
-            // bullet 2: the class, all base classes, and definition scopes
-
-            // class + bases
-            SObjList<BaseClassSubobj const> bases;
-            getSubobjects(bases, ct);
-
-            // put them into 'associated'
-            SFOREACH_OBJLIST(BaseClassSubobj const, bases, iter) {
-              CompoundType *base = iter.data()->ct;
-              associated.prependUnique(base);
-
-              // get definition namespace too
-              if (base->parentScope) {
-                associated.prependUnique(base->parentScope);
-              }
-              else {
-                // parent is not named.. I'm pretty sure in this case
-                // any names that should be found will be found by
-                // ordinary lookup, so it will not matter whether the
-                // parent scope of 'base' gets added to 'associated'
-              }
-            }
+bool AssociatedScopes::operator== (AssociatedScopes const &obj) const
+{
+  return m_count == obj.m_count &&
+         std::equal(m_scopes, m_scopes+m_count, obj.m_scopes);
+}
 
-            // also, class of which it is a member (in/t0569.cc)
-            if (ct->parentScope && ct->parentScope->curCompound) {
-              CompoundType *container = ct->parentScope->curCompound;
-              associated.prependUnique(container);
 
-              // and its definition scope
-              if (container->parentScope) {
-                associated.prependUnique(container->parentScope);
-              }
-            }
-          }
-          else {
-            // bullet 7: template instantiation: definition scope plus
-            // associated scopes of template type arguments
+bool ArgDepLookupKey::operator== (ArgDepLookupKey const &obj) const
+{
+  return m_name == obj.m_name &&
+         m_flags == obj.m_flags &&
+         m_scopes == obj.m_scopes;
+}
 
-            // definition scope
-            if (ct->parentScope) {
-              associated.prependUnique(ct->parentScope);
-            }
+size_t ArgDepLookupKeyHash::operator() (ArgDepLookupKey const &k) const
+{
+  return ((size_t)(uintptr_t)k.m_name * 31 + (size_t)k.m_flags) * 31 +
+         (size_t)(uintptr_t)k.m_scopes;
+}
 
-            // I am disabling this because:
-            //   - it fixes in/k0009.cc
-            //   - it is hard (though not impossible) to conjure a
-            //     situation where a name found in an argument's
-            //     associated scope could be used
-            //   - gcc and edg seem not to do it, at least as evidenced
-            //     by their acceptance of in/k0009.cc
-            // In general, arg-dep lookup is poorly tested right now.
-            // What I should do at some point is write a few dozen
-            // tests that hit all the corners, and determine the extent
-            // to which my interpretation of the standard agrees with
-            // gcc and edg.
-            //
-            // 2005-08-09 (in/t0532.cc): my current hypothesis is that
-            // template args are used, but that when searching classes,
-            // only friend declarations are considered
-            //
-            // look at template arguments
-            TemplateInfo *ti = ct->templateInfo();
-            xassert(ti);
-            FOREACH_OBJLIST(STemplateArgument, ti->arguments, iter) {
-              STemplateArgument const *arg = iter.data();
-              if (arg->isType()) {
-                getAssociatedScopes(associated, arg->getType());
-              }
-              else if (arg->isTemplate()) {
-                // TODO: implement this (template template parameters)
-              }
-            }
-          }
-          break;
-        }
 
-        case AtomicType::T_ENUM: {
-          // bullet 3 (enum): definition scope
-          EnumType *et = atomic->asEnumType();
-          if (et->typedefVar &&        // ignore anonymous enumerations...
-              et->typedefVar->m_containingScope) {
-            associated.prependUnique(et->typedefVar->m_containingScope);
-          }
-          break;
-        }
-      }
-      break;
+// return the interned list with the contents of 'seq'
+AssociatedScopes const *Env::internAssociatedScopes(
+  std::vector<Scope*> const &seq)
+{
+  AssociatedScopes probe(seq.data(), seq.size());
+  auto it = m_associatedScopeLists.find(&probe);
+  if (it != m_associatedScopeLists.end()) {
+    return *it;
+  }
+
+  Scope **scopes = new Scope*[seq.size()];
+  std::copy(seq.begin(), seq.end(), scopes);
+  AssociatedScopes *ret = new AssociatedScopes(scopes, seq.size());
+  m_associatedScopeLists.insert(ret);
+  return ret;
+}
+
+
+// remove all but the first occurrence of each scope in 'seq'
+void Env::removeDuplicateScopes(std::vector<Scope*> &seq)
+{
+  if (seq.size() < 2) {
+    return;
+  }
+
+  // sort (scope, position) pairs so the first occurrence of each
+  // scope leads its run, then blank out the rest of the run
+  m_assocSortScratch.clear();
+  for (int i=0; i < (int)seq.size(); i++) {
+    m_assocSortScratch.push_back(std::make_pair(seq[i], i));
+  }
+  std::sort(m_assocSortScratch.begin(), m_assocSortScratch.end());
+  for (int i=1; i < (int)m_assocSortScratch.size(); i++) {
+    if (m_assocSortScratch[i].first == m_assocSortScratch[i-1].first) {
+      seq[m_assocSortScratch[i].second] = NULL;
     }
+  }
+
+  seq.erase(std::remove(seq.begin(), seq.end(), (Scope*)NULL), seq.end());
+}
+
+
+// Key for 'm_typeAssociatedScopes'.  References, pointers and arrays
+// have the same associated scopes as what they refer to, and cv
+// qualifiers do not matter, so those are stripped.
+static void const *assocScopesKey(Type *type)
+{
+  while (type->isReferenceType() ||
+         type->isPointerType() ||
+         type->isArrayType()) {
+    type = type->getAtType();
+  }
+  if (type->isCVAtomicType()) {
+    return type->asCVAtomicType()->atomic;
+  }
+  return type;
+}
+
+
+// get scopes associated with 'type'; C++98 3.4.2 para 2; set
+// 'settled' to false if the answer could change later in the
+// translation unit
+AssociatedScopes const *Env::getAssociatedScopes(Type *type, bool &settled)
+{
+  void const *key = assocScopesKey(type);
+
+  m_numAssocScopeQueries++;
+  auto it = m_typeAssociatedScopes.find(key);
+  if (it != m_typeAssociatedScopes.end()) {
+    m_numAssocScopeHits++;
+    return it->second;
+  }
+
+  std::vector<Scope*> seq;
+  bool mySettled = true;
+  computeAssociatedScopes(seq, type, mySettled);
+  removeDuplicateScopes(seq);
+
+  AssociatedScopes const *ret = internAssociatedScopes(seq);
+  if (mySettled) {
+    m_typeAssociatedScopes[key] = ret;
+  }
+  else {
+    settled = false;
+  }
+  return ret;
+}
+
+
+// append to 'seq' the scopes associated with 'type'
+void Env::addAssociatedScopes(std::vector<Scope*> &seq, Type *type,
+                              bool &settled)
+{
+  AssociatedScopes const *list = getAssociatedScopes(type, settled);
+  seq.insert(seq.end(), list->m_scopes, list->m_scopes + list->m_count);
+}
+
+
+// the uncached computation for 'getAssociatedScopes'; the scopes are
+// appended in the order 'associatedScopeLookup' should search them
+// in reverse
+void Env::computeAssociatedScopes(std::vector<Scope*> &seq, Type *type,
+                                  bool &settled)
+{
+  switch (type->getTag()) {
+    default:
+      xfailure("bad type tag");
+
+    case Type::T_ATOMIC:
+      computeAtomicAssociatedScopes(seq, type->asCVAtomicType()->atomic,
+                                    settled);
+      break;
 
     case Type::T_REFERENCE:
       // implicitly skipped as being an lvalue
     case Type::T_POINTER:
     case Type::T_ARRAY:
       // bullet 4: skip to atType
-      getAssociatedScopes(associated, type->getAtType());
+      computeAssociatedScopes(seq, type->getAtType(), settled);
       break;
 
     case Type::T_FUNCTION: {
       // bullet 5: recursively look at param/return types
       FunctionType *ft = type->asFunctionType();
-      getAssociatedScopes(associated, ft->retType);
+      addAssociatedScopes(seq, ft->retType, settled);
       SFOREACH_OBJLIST(Variable, ft->params, iter) {
-        getAssociatedScopes(associated, iter.data()->type);
+        addAssociatedScopes(seq, iter.data()->type, settled);
       }
       break;
     }
@@ -4510,9 +4724,131 @@ void Env::getAssociatedScopes(SObjList<Scope> &associated, Type *type)
       // bullet 6/7: the 'inClassNAT', plus 'atType'
       PointerToMemberType *ptm = type->asPointerToMemberType();
       if (ptm->inClassNAT->isCompoundType()) {
-        associated.prependUnique(ptm->inClassNAT->asCompoundType());
+        seq.push_back(ptm->inClassNAT->asCompoundType());
+      }
+      addAssociatedScopes(seq, ptm->atType, settled);
+      break;
+    }
+  }
+}
+
+
+// True if 'ct' is defined and closed, so the bases and 'parentScope'
+// that 'computeAtomicAssociatedScopes' looks at are final.
+static bool isSettledClass(CompoundType const *ct)
+{
+  return ct->hasFinishedDefinition() && !ct->isOnScopeStack();
+}
+
+
+// like 'computeAssociatedScopes', for an AtomicType
+void Env::computeAtomicAssociatedScopes(std::vector<Scope*> &seq,
+                                        AtomicType *atomic, bool &settled)
+{
+  switch (atomic->getTag()) {
+    default:
+      // other cases: nothing
+      return;
+
+    case AtomicType::T_SIMPLE:
+      // bullet 1: nothing
+      return;
+
+    case AtomicType::T_COMPOUND: {
+      CompoundType *ct = atomic->asCompoundType();
+      if (!ct->isInstantiation()) {
+        // bullet 2: the class, all base classes, and definition scopes
+        if (!isSettledClass(ct)) {
+          settled = false;
+        }
+
+        // class + bases
+        SObjList<BaseClassSubobj const> bases;
+        getSubobjects(bases, ct);
+
+        // put them into 'associated'
+        SFOREACH_OBJLIST(BaseClassSubobj const, bases, iter) {
+          CompoundType *base = iter.data()->ct;
+          seq.push_back(base);
+
+          // get definition namespace too
+          if (base->parentScope) {
+            seq.push_back(base->parentScope);
+          }
+          else {
+            // parent is not named.. I'm pretty sure in this case
+            // any names that should be found will be found by
+            // ordinary lookup, so it will not matter whether the
+            // parent scope of 'base' gets added to 'associated'
+          }
+        }
+
+        // also, class of which it is a member (in/t0569.cc)
+        if (ct->parentScope && ct->parentScope->curCompound) {
+          CompoundType *container = ct->parentScope->curCompound;
+          seq.push_back(container);
+
+          // and its definition scope
+          if (!isSettledClass(container)) {
+            settled = false;
+          }
+          if (container->parentScope) {
+            seq.push_back(container->parentScope);
+          }
+        }
+      }
+      else {
+        // bullet 7: template instantiation: definition scope plus
+        // associated scopes of template type arguments
+        if (!isSettledClass(ct)) {
+          settled = false;
+        }
+
+        // definition scope
+        if (ct->parentScope) {
+          seq.push_back(ct->parentScope);
+        }
+
+        // I am disabling this because:
+        //   - it fixes in/k0009.cc
+        //   - it is hard (though not impossible) to conjure a
+        //     situation where a name found in an argument's
+        //     associated scope could be used
+        //   - gcc and edg seem not to do it, at least as evidenced
+        //     by their acceptance of in/k0009.cc
+        // In general, arg-dep lookup is poorly tested right now.
+        // What I should do at some point is write a few dozen
+        // tests that hit all the corners, and determine the extent
+        // to which my interpretation of the standard agrees with
+        // gcc and edg.
+        //
+        // 2005-08-09 (in/t0532.cc): my current hypothesis is that
+        // template args are used, but that when searching classes,
+        // only friend declarations are considered
+        //
+        // look at template arguments
+        TemplateInfo *ti = ct->templateInfo();
+        xassert(ti);
+        FOREACH_OBJLIST(STemplateArgument, ti->arguments, iter) {
+          STemplateArgument const *arg = iter.data();
+          if (arg->isType()) {
+            addAssociatedScopes(seq, arg->getType(), settled);
+          }
+          else if (arg->isTemplate()) {
+            // TODO: implement this (template template parameters)
+          }
+        }
+      }
+      break;
+    }
+
+    case AtomicType::T_ENUM: {
+      // bullet 3 (enum): definition scope
+      EnumType *et = atomic->asEnumType();
+      if (et->typedefVar &&        // ignore anonymous enumerations...
+          et->typedefVar->m_containingScope) {
+        seq.push_back(et->typedefVar->m_containingScope);
       }
-      getAssociatedScopes(associated, ptm->atType);
       break;
     }
   }
@@ -4532,10 +4868,17 @@ void Env::associatedScopeLookup(LookupSet &candidates, StringRef name,
     return;
   }
 
-  // union over all arguments of "associated" namespaces and classes
-  SObjList<Scope> associated;
+  // union over all arguments of "associated" namespaces and classes,
+  // keeping the first occurrence of each
+  bool settled = true;
+  m_assocScratch.clear();
   for (int i=0; i < argTypes.length(); i++) {
-    getAssociatedScopes(associated, argTypes[i]);
+    AssociatedScopes const *list = getAssociatedScopes(argTypes[i], settled);
+    m_assocScratch.insert(m_assocScratch.end(),
+                          list->m_scopes, list->m_scopes + list->m_count);
+  }
+  if (argTypes.length() > 1) {
+    removeDuplicateScopes(m_assocScratch);
   }
 
   // 3.4.2 para 3: ignore 'using' directives for these lookups
@@ -4546,15 +4889,63 @@ void Env::associatedScopeLookup(LookupSet &candidates, StringRef name,
   // include in/t0532.cc, in/t0471.cc and in/t0569.cc
   flags |= LF_ARG_DEP;
 
-  // get candidates from the lookups in the "associated" scopes
-  SFOREACH_OBJLIST_NC(Scope, associated, scopeIter) {
-    Scope *s = scopeIter.data();
-    if ((flags & LF_SKIP_CLASSES) && s->isClassScope()) {
-      continue;
+  if (m_assocScratch.empty()) {
+    return;
+  }
+
+  // the scopes are searched latest first
+  std::reverse(m_assocScratch.begin(), m_assocScratch.end());
+
+  ArgDepLookupKey key;
+  key.m_name = name;
+  key.m_flags = flags;
+  key.m_scopes = internAssociatedScopes(m_assocScratch);
+  Scope * const *scopes = key.m_scopes->m_scopes;
+  int numScopes = key.m_scopes->m_count;
+
+  // The lookups only depend on the contents of the scopes, so a
+  // previous result is good if none of them has changed since.
+  m_numArgDepLookups++;
+  auto it = m_argDepLookups.find(key);
+  bool valid = it != m_argDepLookups.end();
+  for (int i=0; valid && i < numScopes; i++) {
+    valid = it->second.m_changeCounts[i] == scopes[i]->getChangeCount();
+  }
+
+  if (valid) {
+    m_numArgDepLookupHits++;
+  }
+  else {
+    // get candidates from the lookups in the "associated" scopes; the
+    // lookups can reenter this function, so do not hold on to 'it'
+    ArgDepLookupResult fresh;
+    fresh.m_changeCounts.resize(numScopes);
+    fresh.m_found.resize(numScopes);
+    for (int i=0; i < numScopes; i++) {
+      Scope *s = scopes[i];
+      fresh.m_changeCounts[i] = s->getChangeCount();
+      if ((flags & LF_SKIP_CLASSES) && s->isClassScope()) {
+        fresh.m_found[i] = NULL;
+      }
+      else {
+        fresh.m_found[i] = s->lookupVariable(name, env, flags);
+      }
     }
 
-    // lookup
-    Variable *v = s->lookupVariable(name, env, flags);
+    // Stale entries are overwritten in place, so the map only grows
+    // with new keys; bound it anyway.
+    if (m_argDepLookups.size() >= ARG_DEP_LOOKUP_LIMIT &&
+        m_argDepLookups.find(key) == m_argDepLookups.end()) {
+      m_numArgDepLookupFlushes++;
+      m_argDepLookups.clear();
+    }
+    it = m_argDepLookups.emplace(key, ArgDepLookupResult()).first;
+    it->second = std::move(fresh);
+  }
+  ArgDepLookupResult const &result = it->second;
+
+  for (int i=0; i < numScopes; i++) {
+    Variable *v = result.m_found[i];
 
     // toss them into the set
     if (v) {
@@ -4565,9 +4956,11 @@ void Env::associatedScopeLookup(LookupSet &candidates, StringRef name,
         env.error(loc(), stringc
           << "during argument-dependent lookup of '" << name
           << "', found non-function of type '" << v->type->toString()
-          << "' in " << s->scopeName());
+          << "' in " << scopes[i]->scopeName());
       }
       else {
+        // this expands the overload set as it is now, so it is ok
+        // if overloads were added since 'v' was found
         addCandidates(candidates, v);
       }
     }
@@ -4688,6 +5081,30 @@ Type *Env::resolveDQTs(SourceLoc loc, Type *t)
 
 
 Type *Env::resolveDQTs_atomic(SourceLoc loc, AtomicType *t)
+{
+  if (!t->isPseudoInstantiation() && !t->isDependentQType()) {
+    return NULL;
+  }
+
+  m_numDQTQueries++;
+  auto it = m_resolvedDQTs.find(t);
+  if (it != m_resolvedDQTs.end()) {
+    m_numDQTHits++;
+    return it->second;
+  }
+
+  // Do not remember failures that were reported as errors, since
+  // the error may be discarded along with an ambiguous alternative,
+  // and then needs to be reported again in the surviving one.
+  unsigned long prevAdditions = errors.numAdditions();
+  Type *ret = resolveDQTs_atomic_uncached(loc, t);
+  if (errors.numAdditions() == prevAdditions) {
+    m_resolvedDQTs[t] = ret;
+  }
+  return ret;
+}
+
+Type *Env::resolveDQTs_atomic_uncached(SourceLoc loc, AtomicType *t)
 {
   // (in/t0503.cc) might need to resolve DQTs inside template args
   if (t->isPseudoInstantiation()) {
@@ -4856,6 +5273,59 @@ bool sameArguments(ObjList<STemplateArgument> const &args1,
 }
 
 
+bool QualifierLookupKey::operator== (QualifierLookupKey const &obj) const
+{
+  return m_scope == obj.m_scope &&
+         m_name == obj.m_name &&
+         m_args == obj.m_args &&
+         m_flags == obj.m_flags;
+}
+
+size_t QualifierLookupKeyHash::operator() (QualifierLookupKey const &k) const
+{
+  return ((size_t)(uintptr_t)k.m_scope * 31 +
+          (size_t)(uintptr_t)k.m_name) * 31 +
+         (size_t)(uintptr_t)k.m_args +
+         (size_t)k.m_flags;
+}
+
+
+// true if the lookup of 'qual' in 'scope' can be memoized, in which
+// case 'key' is filled in
+static bool makeQualifierLookupKey(QualifierLookupKey &key,
+  Scope * /*nullable*/ scope, PQ_qualifier const *qual, LookupFlags flags)
+{
+  // lookups in the scope stack depend on context
+  if (!scope) {
+    return false;
+  }
+
+  // members of a class can be added until it is complete
+  if (scope->curCompound && !scope->curCompound->isComplete()) {
+    return false;
+  }
+
+  // lookups through using-directives depend on other scopes too
+  if (scope->usingEdges.isNotEmpty() || scope->activeUsingEdges.isNotEmpty()) {
+    return false;
+  }
+
+  InternedSArgs const *args = NULL;
+  if (qual->sargs.isNotEmpty()) {
+    args = tfac.templateArgumentLists().intern(qual->sargs);
+    if (!args) {
+      return false;      // not concrete
+    }
+  }
+
+  key.m_scope = scope;
+  key.m_name = qual->qualifier;
+  key.m_args = args;
+  key.m_flags = flags;
+  return true;
+}
+
+
 void Env::lookupPQ(LookupSet &set, PQName *name, LookupFlags flags)
 {
   // this keeps track of where the next lookup will occur; NULL means
@@ -4896,10 +5366,38 @@ void Env::lookupPQ_withScope(LookupSet &set, PQName *name, LookupFlags flags,
     }
 
     else {
+      // have we done this lookup before?
+      QualifierLookupKey key;
+      bool cacheable = makeQualifierLookupKey(key, scope, qual, flags);
+      if (cacheable) {
+        m_numQualifierLookups++;
+        auto it = m_qualifierLookups.find(key);
+        if (it != m_qualifierLookups.end() &&
+            it->second.m_changeCount == scope->getChangeCount()) {
+          m_numQualifierLookupHits++;
+          qual->qualifierVar = it->second.m_qualifierVar;
+          scope = it->second.m_denotedScope;
+          goto bottom_of_loop;
+        }
+      }
+      unsigned long origNumAdditions =
+        cacheable? errors.numAdditions() : 0;
+      Scope *searchedScope = scope;
+
       // lookup this qualifier in 'scope'
       Variable *svar = lookupScopeVar(scope, qual->qualifier, flags);
       qual->qualifierVar = svar;
 
+      // self-names are context dependent, and applying arguments to a
+      // non-template yields an error (possibly suppressed) and recovery
+      if (!svar ||
+          svar->hasFlag(DF_SELFNAME) ||
+          (qual->sargs.isNotEmpty() &&
+           !(svar->type->isCompoundType() &&
+             svar->type->asCompoundType()->isTemplate()))) {
+        cacheable = false;
+      }
+
       if (svar && svar->hasFlag(DF_SELFNAME)) {
         if (qual->sargs.isNotEmpty()) {
           // 2005-03-04: referring to the self-name but passing args:
@@ -4996,6 +5494,15 @@ void Env::lookupPQ_withScope(LookupSet &set, PQName *name, LookupFlags flags,
       if (scope->curCompound) {
         env.ensureCompleteCompound("use as qualifier", scope->curCompound);
       }
+
+      if (cacheable &&
+          errors.numAdditions() == origNumAdditions &&
+          (!scope->curCompound || scope->curCompound->isComplete())) {
+        QualifierLookupResult &result = m_qualifierLookups[key];
+        result.m_changeCount = searchedScope->getChangeCount();
+        result.m_qualifierVar = qual->qualifierVar;
+        result.m_denotedScope = scope;
+      }
     }
 
   bottom_of_loop:
@@ -5390,7 +5897,7 @@ Scope *Env::createNamespace(SourceLoc loc, StringRef name)
   s->namespaceVar = v;
 
   // point the variable at it so we can find it later
-  v->m_denotedScope = s;
+  v->setNamespaceScope(s);
 
   // hook it into the scope tree; this must be done before the
   // using edge is added, for anonymous scopes
@@ -5920,9 +6427,12 @@ Type *Env::warning(rostring msg)
 
 Type *Env::warning(SourceLoc loc, rostring msg)
 {
-  string instLoc = instLocStackString();
-  TRACE("error", "warning: " << msg << instLoc);
-  errors.addError(new ErrorMsg(loc, msg, EF_WARNING, instLoc));
+  ErrorMsg *e = new ErrorMsg(loc, msg, EF_WARNING);
+  if (instantiationLocStack.isNotEmpty()) {
+    e->setInstLocs(instantiationLocStack);
+  }
+  TRACE("error", "warning: " << msg << e->instLoc());
+  errors.addError(e);
   return getSimpleType(ST_ERROR);
 }
 
@@ -6053,14 +6563,22 @@ Type *Env::error(SourceLoc L, rostring msg, ErrorFlags eflags)
   return errorType();
 }
 
+Type *Env::error(SourceLoc L, ErrorTextFunc func, StringRef name,
+                 ErrorFlags eflags)
+{
+  addError(new ErrorMsg(L, func, name, eflags));
+
+  return errorType();
+}
+
 
 // I want this function to always be last in this file, so I can easily
 // find it to put a breakpoint in it.
 void Env::addError(ErrorMsg * /*owner*/ e)
 {
-  string instLoc = instLocStackString();
-  if (instLoc.length()) {
-    e->instLoc = instLoc;
+  // remember the instantiation context, but do not render it yet
+  if (instantiationLocStack.isNotEmpty()) {
+    e->setInstLocs(instantiationLocStack);
   }
 
   if (disambiguateOnly) {
@@ -6078,7 +6596,7 @@ void Env::addError(ErrorMsg * /*owner*/ e)
   }
 
   TRACE("error", errorFlagBlock(e->flags)
-              << toString(e->loc) << ": " << e->msg << instLoc);
+              << toString(e->loc) << ": " << e->msg() << e->instLoc());
 
   // breakpoint typically goes on the next line
   ErrorList::addError(e);
@@ -8,7 +8,7 @@
 
 // elsa
 #include "ast_build.h"                 // ElsaASTBuild
-#include "builtinops.h"                // CandidateSet
+#include "builtinops.h"                // CandidateSet, BuiltinCandidateCache
 #include "cc-ast.h"                    // C++ ast components
 #include "cc-err.h"                    // ErrorList
 #include "cc-lang.h"                   // CCLang, Bool3
@@ -16,8 +16,9 @@
 #include "cc-type.h"                   // Type, AtomicType, etc. (r)
 #include "implconv-fwd.h"              // ImplicitConversion
 #include "mflags.h"                    // MatchFlags
-#include "mtype-fwd.h"                 // MType
-#include "template-fwd.h"              // DelayedFuncInst
+#include "mtype.h"                     // MType, TypeEqualityCache
+#include "overload-fwd.h"              // CandidatePool, OverloadStats, etc.
+#include "template-fwd.h"              // DelayedFuncInst, InternedSArgs
 #include "typelistiter-fwd.h"          // TypeListIter
 #include "variable.h"                  // Variable (r)
 
@@ -31,6 +32,12 @@
 #include "sobjstack.h"                 // SObjStack
 #include "strobjdict.h"                // StrObjDict
 
+// libc++
+#include <unordered_map>               // std::unordered_map
+#include <unordered_set>               // std::unordered_set
+#include <utility>                     // std::pair
+#include <vector>                      // std::vector
+
 class StringTable;                     // strtable.h
 
 
@@ -54,6 +61,98 @@ enum InferArgFlags {
 ENUM_BITWISE_OPS(InferArgFlags, IA_ALL)
 
 
+// An immutable list of associated scopes (3.4.2), in the order they
+// are searched.  Lists are interned by 'Env::internAssociatedScopes',
+// so two lists with the same contents are the same object.
+class AssociatedScopes {
+public:      // data
+  // the scopes; owned by the Env for interned lists
+  Scope * const *m_scopes;
+  int m_count;
+
+  // hash of the contents
+  size_t m_hash;
+
+public:      // funcs
+  AssociatedScopes(Scope * const *scopes, int count);
+
+  bool operator== (AssociatedScopes const &obj) const;
+};
+
+class AssociatedScopesHash {
+public:
+  size_t operator() (AssociatedScopes const *s) const { return s->m_hash; }
+};
+
+class AssociatedScopesEqual {
+public:
+  bool operator() (AssociatedScopes const *a, AssociatedScopes const *b) const
+    { return *a == *b; }
+};
+
+
+// key for memoizing 'Env::associatedScopeLookup'
+class ArgDepLookupKey {
+public:      // data
+  StringRef m_name;
+  LookupFlags m_flags;
+
+  // the associated scopes searched (interned)
+  AssociatedScopes const *m_scopes;
+
+public:      // funcs
+  bool operator== (ArgDepLookupKey const &obj) const;
+};
+
+class ArgDepLookupKeyHash {
+public:
+  size_t operator() (ArgDepLookupKey const &k) const;
+};
+
+// what 'Env::associatedScopeLookup' found in each scope of a key
+class ArgDepLookupResult {
+public:      // data
+  // 'getChangeCount()' of each scope at the time of the lookup; the
+  // result is only valid while these are unchanged
+  std::vector<int> m_changeCounts;
+
+  // result of the lookup in each scope, or NULL
+  std::vector<Variable*> m_found;
+};
+
+
+// key for memoizing one qualifier step of 'Env::lookupPQ_withScope'
+class QualifierLookupKey {
+public:      // data
+  Scope *m_scope;                    // scope searched for the qualifier
+  StringRef m_name;                  // the qualifier
+  InternedSArgs const *m_args;       // its template arguments, or NULL
+  LookupFlags m_flags;
+
+public:      // funcs
+  bool operator== (QualifierLookupKey const &obj) const;
+};
+
+class QualifierLookupKeyHash {
+public:
+  size_t operator() (QualifierLookupKey const &k) const;
+};
+
+// what that qualifier step yielded
+class QualifierLookupResult {
+public:      // data
+  // 'getChangeCount()' of the searched scope; the result is only
+  // valid while this is unchanged
+  int m_changeCount;
+
+  // what 'lookupScopeVar' found, stored in PQ_qualifier::qualifierVar
+  Variable *m_qualifierVar;
+
+  // the scope denoted by the qualifier and its arguments
+  Scope *m_denotedScope;
+};
+
+
 // the entire semantic analysis state
 class Env : protected ErrorList, private SourceLocProvider {
 protected:   // data
@@ -67,8 +166,29 @@ protected:   // data
   //
   // NOTE: If a scope has a non-NULL curCompound or namespaceVar,
   // then this list does *not* own it.  Otherwise it does own it.
+  //
+  // Changes must keep 'm_scopeFrames' in sync; normally that means
+  // going through 'pushScope' and 'popScope'.
   ObjList<Scope> scopes;
 
+  // One entry per element of 'scopes', in the opposite order
+  // (outermost first).  Besides the scope, each entry records where
+  // the nearest scope at or outside it with certain properties is, so
+  // that 'enclosingKindScope', 'outerScope' and 'nonTemplateScope'
+  // need not walk 'scopes'.
+  struct ScopeFrame {
+    Scope *m_scope;
+
+    // For each ScopeKind, the index in 'm_scopeFrames' of the
+    // innermost entry at or below this one with that kind, or -1.
+    int m_nearestOfKind[NUM_SCOPEKINDS];
+
+    // Likewise for the answers of 'outerScope' and 'nonTemplateScope'.
+    int m_nearestOuter;
+    int m_nearestNonTemplate;
+  };
+  std::vector<ScopeFrame> m_scopeFrames;
+
   // when true, all errors are ignored (dropped on floor) except:
   //   - errors with the 'disambiguates' flag set
   //   - unimplemented functionality
@@ -90,6 +210,77 @@ protected:   // data
   // set of function templates whose instantiation has been delayed
   ObjList<DelayedFuncInst> delayedFuncInsts;
 
+  // Results of 'equivalentTypes' and, while this Env is alive,
+  // 'BaseType::equals'.  The types outlive the Env, so an address in
+  // here is never reused for another type.
+  TypeEqualityCache m_typeEqualityCache;
+
+  // Cache for 'resolveDQTs_atomic': map from a DependentQType or
+  // PseudoInstantiation to its resolution, or NULL if it does not
+  // resolve.  The answer depends on which template class definitions
+  // are on the scope stack, so this is emptied whenever a class scope
+  // is pushed or popped (see 'classScopesChanged').
+  std::unordered_map<AtomicType*, Type*> m_resolvedDQTs;
+
+  // Statistics for 'm_resolvedDQTs'.
+  unsigned long m_numDQTQueries;
+  unsigned long m_numDQTHits;
+  unsigned long m_numDQTFlushes;
+
+  // Interned associated scope lists (owner).
+  std::unordered_set<AssociatedScopes*, AssociatedScopesHash,
+                     AssociatedScopesEqual> m_associatedScopeLists;
+
+  // Associated scopes (3.4.2) of types, keyed by 'assocScopesKey', in
+  // the order 'addAssociatedScopes' appends them and without
+  // duplicates.  Only types whose classes are finished and closed (so
+  // their bases and 'parentScope' will not change) get entries.
+  std::unordered_map<void const*, AssociatedScopes const*>
+    m_typeAssociatedScopes;
+
+  // Results of 'associatedScopeLookup'.  Each entry checks the change
+  // counts of its scopes, and the whole map is cleared when it reaches
+  // ARG_DEP_LOOKUP_LIMIT entries.
+  std::unordered_map<ArgDepLookupKey, ArgDepLookupResult, ArgDepLookupKeyHash>
+    m_argDepLookups;
+  enum { ARG_DEP_LOOKUP_LIMIT = 4096 };
+
+  // Scratch space for 'associatedScopeLookup'.
+  std::vector<Scope*> m_assocScratch;
+  std::vector<std::pair<Scope*, int>> m_assocSortScratch;
+
+  // Statistics for the above.
+  unsigned long m_numAssocScopeQueries;
+  unsigned long m_numAssocScopeHits;
+  unsigned long m_numArgDepLookups;
+  unsigned long m_numArgDepLookupHits;
+  unsigned long m_numArgDepLookupFlushes;
+
+  // Results of individual qualifier lookups in 'lookupPQ_withScope'.
+  // Only lookups in an explicit, complete scope without using-edges,
+  // with concrete template arguments, and which produced no errors
+  // are recorded.
+  std::unordered_map<QualifierLookupKey, QualifierLookupResult,
+                     QualifierLookupKeyHash> m_qualifierLookups;
+  unsigned long m_numQualifierLookups;
+  unsigned long m_numQualifierLookupHits;
+
+  // Default arguments of function template instantiations that were
+  // shared with the primary, and those later copied to be tcheck'd
+  // (see 'cloneDefaultArguments' in template.cc).
+  unsigned long m_numSharedDefaultArgs;
+  unsigned long m_numDefaultArgCopies;
+
+  // Calls to 'findInOverloadSet' answered with the set's signature
+  // index, and the members those calls did not have to compare.
+  unsigned long m_numOverloadIndexLookups;
+  unsigned long m_numOverloadIndexSkipped;
+
+private:     // data
+  // memo of candidates drawn from 'builtinBinaryOperator'; see
+  // 'builtinCandidateCache'
+  BuiltinCandidateCache m_builtinCandidateCache;
+
 public:      // data
   // nesting level of disambiguation passes; 0 means not disambiguating;
   // this is used for certain kinds of error reporting and suppression
@@ -224,6 +415,18 @@ public:      // data
   ArrayStack<Variable*> builtinUnaryOperator[NUM_OVERLOADABLE_OPS];
   ObjArrayStack<CandidateSet> builtinBinaryOperator[NUM_OVERLOADABLE_OPS];
 
+private:     // data
+  // recycled storage for OverloadResolver; see 'candidatePool'
+  Owner<CandidatePool> m_candidatePool;
+
+  // memo of 'getConversionOperator' results; see
+  // 'conversionOperatorCache'
+  Owner<ConversionOperatorCache> m_conversionOperatorCache;
+
+  // overload resolution statistics; see 'overloadStats'
+  Owner<OverloadStats> m_overloadStats;
+
+public:      // data
   // when this is true, all template function instantiations are
   // delayed until the end of the translation unit
   bool delayFunctionInstantiation;
@@ -305,8 +508,11 @@ private:     // funcs
     (CompoundType *ct, ObjList<STemplateArgument> const &args);
 
   bool equivalentSignatures(FunctionType *ft1, FunctionType *ft2);
+  // This consults the TypeEqualityCache before doing the comparison.
   bool equivalentTypes(Type const *t1, Type const *t2,
                        MatchFlags mflags = MF_NONE);
+  bool equivalentTypes_uncached(Type const *t1, Type const *t2,
+                                MatchFlags mflags);
 
   Variable *getPrimaryOrSpecialization
     (TemplateInfo *tinfo, ObjList<STemplateArgument> const &sargs);
@@ -315,6 +521,17 @@ private:     // funcs
 
   Scope *createScope(ScopeKind sk);
 
+  // Push/pop 's' on 'scopes' and 'm_scopeFrames'.
+  void pushScope(Scope *s);
+  Scope *popScope();
+
+  // Append the entry for 's' to 'm_scopeFrames'.
+  void pushScopeFrame(Scope *s);
+
+  // Scope of entry 'index' in 'm_scopeFrames', or NULL if 'index' is -1.
+  Scope *frameScope(int index) const
+    { return index < 0? NULL : m_scopeFrames[index].m_scope; }
+
   void mergeDefaultArguments(SourceLoc loc, Variable *prior, FunctionType *type);
 
   // Implement SourceLocProvider.
@@ -340,6 +557,10 @@ public:      // funcs
   void extendScope(Scope *s);     // push onto stack, but don't own
   void retractScope(Scope *s);    // paired with extendScope()
 
+  // called when 's' is pushed or popped; discards 'm_resolvedDQTs'
+  // if 's' is a class scope
+  void classScopesChanged(Scope *s);
+
   // the current, innermost scope
   Scope *scope() { return scopes.first(); }
   Scope const *scopeC() const { return scopes.firstC(); }
@@ -347,6 +568,25 @@ public:      // funcs
   // print out the variables in every scope with serialNumber-s
   void gdbScopes();
 
+  // Print hit/miss counts and sizes of the caches used during type
+  // checking.  Enabled with "-tr cacheStats".
+  void printCacheStats(ostream &os) const;
+
+  // Candidates drawn from 'builtinBinaryOperator', for OverloadResolver.
+  BuiltinCandidateCache &builtinCandidateCache()
+    { return m_builtinCandidateCache; }
+
+  // Recycled Candidate storage, for OverloadResolver.
+  CandidatePool &candidatePool() { return *m_candidatePool; }
+
+  // Memo of 'getConversionOperator' results.
+  ConversionOperatorCache &conversionOperatorCache()
+    { return *m_conversionOperatorCache; }
+
+  // Overload resolution statistics, or NULL unless
+  // "-tr overloadStats".
+  OverloadStats * /*nullable*/ overloadStats() { return m_overloadStats; }
+
   // innermost scope that can accept names; the decl flags might
   // be used to choose exactly which scope to use
   Scope *acceptingScope(DeclFlags df = DF_NONE);
@@ -520,6 +760,13 @@ public:      // funcs
   Type *warning(SourceLoc L, rostring msg);
   Type *warning(rostring msg);
   Type *unimp(rostring msg);
+
+  // like 'error', but the text is only rendered, by 'func', if the
+  // error is ever printed; use this for errors that are frequently
+  // discarded, such as lookup failures during disambiguation
+  Type *error(SourceLoc L, ErrorTextFunc func, StringRef name,
+              ErrorFlags eflags = EF_NONE);
+
   void diagnose3(Bool3 b, SourceLoc L, rostring msg, ErrorFlags eflags = EF_NONE);
 
   // this is used when something is nominally an error, but I think
@@ -744,7 +991,16 @@ public:      // funcs
                                         LookupSet &set);
 
   // support for 3.4.2
-  void getAssociatedScopes(SObjList<Scope> &associated, Type *type);
+  AssociatedScopes const *internAssociatedScopes(
+    std::vector<Scope*> const &seq);
+  void removeDuplicateScopes(std::vector<Scope*> &seq);
+  AssociatedScopes const *getAssociatedScopes(Type *type, bool &settled);
+  void addAssociatedScopes(std::vector<Scope*> &seq, Type *type,
+                           bool &settled);
+  void computeAssociatedScopes(std::vector<Scope*> &seq, Type *type,
+                               bool &settled);
+  void computeAtomicAssociatedScopes(std::vector<Scope*> &seq,
+                                     AtomicType *atomic, bool &settled);
   void associatedScopeLookup(LookupSet &candidates, StringRef name,
                              ArrayStack<Type*> const &argTypes, LookupFlags flags);
   void addCandidates(LookupSet &candidates, Variable *var);
@@ -825,6 +1081,7 @@ public:      // funcs
   // handling of DQTs in type specifiers
   Type *resolveDQTs(SourceLoc loc, Type *t);
   Type *resolveDQTs_atomic(SourceLoc loc, AtomicType *t);
+  Type *resolveDQTs_atomic_uncached(SourceLoc loc, AtomicType *t);
   CompoundType *getMatchingTemplateInScope
     (CompoundType *primary, ObjList<STemplateArgument> const &sargs);
   AtomicType *resolveDQTs_pi(SourceLoc loc, PseudoInstantiation *pi);
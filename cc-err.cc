@@ -2,6 +2,7 @@
 // code for cc-err.h
 
 #include "cc-err.h"      // this module
+#include "line-table.h"  // sourceLocString
 #include "trace.h"       // tracingSys
 #include "strutil.h"     // trimWhitespace
 
@@ -11,21 +12,56 @@ ErrorMsg::~ErrorMsg()
 {}
 
 
+string const &ErrorMsg::msg() const
+{
+  if (m_textFunc) {
+    m_msg = m_textFunc(m_textName);
+    m_textFunc = NULL;
+  }
+  return m_msg;
+}
+
+
+string const &ErrorMsg::instLoc() const
+{
+  if (!m_instLocs.empty()) {
+    stringBuilder sb;
+    for (int i = (int)m_instLocs.size()-1; i >= 0; i--) {
+      sb << " (inst from " << sourceLocString(m_instLocs[i]) << ")";
+    }
+    m_instLoc = sb;
+    m_instLocs.clear();
+  }
+  return m_instLoc;
+}
+
+
+void ErrorMsg::setInstLocs(ArrayStack<SourceLoc> const &stack)
+{
+  m_instLocs.clear();
+  m_instLocs.reserve(stack.length());
+  for (int i=0; i < stack.length(); i++) {
+    m_instLocs.push_back(stack[i]);
+  }
+}
+
+
 string ErrorMsg::toString() const
 {
   stringBuilder sb;
-  sb << ::toString(loc) << ": ";
+  sb << sourceLocString(loc) << ": ";
   if (flags & EF_WARNING) {
     sb << "warning";
   }
   else {
     sb << "error";
   }
-  sb << ": " << msg;
+  sb << ": " << msg();
 
   bool msgHasNL = !!strchr(sb.c_str(), '\n');
   bool addedNewline = false;
 
+  string const &instLoc = this->instLoc();
   if (instLoc[0] && msgHasNL) {
     // for a multi-line message, put instLoc on its own line
     // and with no leading whitespace
@@ -61,7 +97,8 @@ string ErrorMsg::toString() const
 
 // ---------------- ErrorList -----------------
 ErrorList::ErrorList()
-  : list()
+  : list(),
+    m_numAdditions(0)
 {}
 
 ErrorList::~ErrorList()
@@ -73,16 +110,23 @@ ErrorList::~ErrorList()
 void ErrorList::addError(ErrorMsg * /*owner*/ obj)
 {
   list.prepend(obj);    // O(1)
+  m_numAdditions++;
 }
 
 void ErrorList::prependError(ErrorMsg * /*owner*/ obj)
 {
   list.append(obj);     // O(n)
+  m_numAdditions++;
 }
 
 
 void ErrorList::takeMessages(ErrorList &src)
 {
+  if (src.list.isEmpty()) {
+    return;
+  }
+  m_numAdditions++;
+
   if (list.isEmpty()) {
     // this is a common case, and 'concat' is O(1) in this case
     list.concat(src.list);
@@ -102,6 +146,9 @@ void ErrorList::takeMessages(ErrorList &src)
 
 void ErrorList::prependMessages(ErrorList &src)
 {
+  if (src.list.isNotEmpty()) {
+    m_numAdditions++;
+  }
   list.concat(src.list);
 }
 
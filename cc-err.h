@@ -5,13 +5,18 @@
 #define CC_ERR_H
 
 #include "cc-err-fwd.h"      // forwards for this module
+#include "live-count.h"      // LiveCount
 
+#include "array.h"           // ArrayStack
 #include "sm-macros.h"       // ENUM_BITWISE_OR
 #include "str.h"             // string
 #include "srcloc.h"          // SourceLoc
+#include "strtable.h"        // StringRef
 
 #include "sm-ostream.h"      // ostream
 
+#include <vector>            // std::vector
+
 
 // flags on errors
 enum ErrorFlags {
@@ -65,27 +70,49 @@ enum ErrorFlags {
 ENUM_BITWISE_OPS(ErrorFlags, EF_ALL)
 
 
+// Renders the text of an ErrorMsg whose formatting was deferred; it
+// gets the name that was passed to the ErrorMsg constructor.
+typedef string (*ErrorTextFunc)(StringRef name);
+
+
 // an error message from the typechecker; I plan to expand
 // this to contain lots of information about the error, but
 // for now it's just a string like every other typechecker
 // produces
-class ErrorMsg {
+//
+// Many errors are discarded unseen, e.g. those from the losing
+// alternatives of an ambiguity, so the text can instead be supplied
+// as an ErrorTextFunc plus arguments, and the instantiation context
+// as a list of locations; both are only rendered if asked for.
+class ErrorMsg : private LiveCount<ErrorMsg> {
 public:
   SourceLoc loc;          // where the error happened
-  string msg;             // english explanation
   ErrorFlags flags;       // various
 
+private:
+  // english explanation; if 'm_textFunc' is not NULL, this has yet
+  // to be computed from it and 'm_textName'
+  mutable string m_msg;
+  mutable ErrorTextFunc m_textFunc;
+  StringRef m_textName;
+
   // string of instantiation locations leading to the error; if
   // no instantiations are involved, this should be "", which does
-  // not require any allocation to store (you can also pass NULL
-  // to mean "")
-  string instLoc;
+  // not require any allocation to store; if 'm_instLocs' is not
+  // empty, this has yet to be computed from it
+  mutable string m_instLoc;
+  mutable std::vector<SourceLoc> m_instLocs;
 
 public:
   ErrorMsg(SourceLoc L, rostring m, ErrorFlags f)
-    : loc(L), msg(m), flags(f), instLoc() {}
+    : loc(L), flags(f), m_msg(m), m_textFunc(NULL), m_textName(NULL),
+      m_instLoc(), m_instLocs() {}
   ErrorMsg(SourceLoc L, rostring m, ErrorFlags f, rostring i)
-    : loc(L), msg(m), flags(f), instLoc(i) {}
+    : loc(L), flags(f), m_msg(m), m_textFunc(NULL), m_textName(NULL),
+      m_instLoc(i), m_instLocs() {}
+  ErrorMsg(SourceLoc L, ErrorTextFunc func, StringRef name, ErrorFlags f)
+    : loc(L), flags(f), m_msg(), m_textFunc(func), m_textName(name),
+      m_instLoc(), m_instLocs() {}
   ~ErrorMsg();
 
   bool isWarning() const
@@ -93,6 +120,15 @@ public:
   bool disambiguates() const
     { return !!(flags & EF_DISAMBIGUATES); }
 
+  // the english explanation
+  string const &msg() const;
+
+  // the instantiation locations, as text
+  string const &instLoc() const;
+
+  // record the instantiation stack, outermost first, for 'instLoc'
+  void setInstLocs(ArrayStack<SourceLoc> const &stack);
+
   string toString() const;
 };
 
@@ -107,6 +143,9 @@ private:
   // this reverse ordering
   ObjList<ErrorMsg> list;
 
+  // number of times messages have been added, by any means
+  unsigned long m_numAdditions;
+
 public:
   ErrorList();                      // empty list initially
   virtual/*...*/ ~ErrorList();      // deallocates error objects
@@ -152,6 +191,11 @@ public:
   // number of errors with any flags set in 'flags'
   int countWithAnyFlag(ErrorFlags flags) const;
 
+  // Incremented whenever messages are added (never decremented), so
+  // callers can tell in O(1) whether anything was reported between
+  // two points, where comparing counts would walk the list.
+  unsigned long numAdditions() const { return m_numAdditions; }
+
   // true if any are EF_DISAMBIGUATES
   bool hasDisambErrors() const;
   bool isEmpty() const { return list.isEmpty(); }
@@ -2417,8 +2417,8 @@ void printFuncInstantiations(PrintEnv &env, Variable const *var)
   TemplateInfo *ti = var->templateInfo();
   SFOREACH_OBJLIST(Variable, ti->instantiations, iter) {
     Variable const *inst = iter.data();
-    if (inst->funcDefn) {
-      inst->funcDefn->print(env);
+    if (inst->getFuncDefn()) {
+      inst->getFuncDefn()->print(env);
     }
     else {
       env << inst->toQualifiedString() << ";    // decl but not defn" << env.br;
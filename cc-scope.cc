@@ -10,6 +10,14 @@
 #include "exc.h"          // unwinding
 
 
+// generation 0 is never current, so new scopes start out stale
+unsigned Scope::s_usingGeneration = 1;
+
+unsigned long Scope::s_numUsingClosureQueries = 0;
+unsigned long Scope::s_numUsingClosureComputations = 0;
+unsigned long Scope::s_numUsingEdgeFastLookups = 0;
+
+
 Scope::Scope(ScopeKind sk, int cc, SourceLoc initLoc)
   : variables(),
     typeTags(),
@@ -25,6 +33,8 @@ Scope::Scope(ScopeKind sk, int cc, SourceLoc initLoc)
     usingEdgesRefct(0),       // common case the sets are empty
     activeUsingEdges(0),
     outstandingActiveEdges(0),
+    m_usingClosure(0),
+    m_usingClosureGeneration(0),
     curCompound(NULL),
     curAccess(AK_PUBLIC),
     curFunction(NULL),
@@ -313,28 +323,6 @@ Variable * NULLABLE Scope::addVariableForLookupOnly(Variable *v)
 }
 
 
-// is 'ancestor' an ancestor of 'child'?
-bool hasAncestor(BaseClassSubobj const *child, BaseClassSubobj const *ancestor)
-{
-  // Unfortunately, I can't do a DFS using the 'visited' fields,
-  // because this query happens right in the middle of *another* DFS
-  // that is using those same fields.  Oh well, just to it without
-  // the 'visited' flags, and take the possibly exponential hit ...
-
-  if (child == ancestor) {
-    return true;
-  }
-
-  SFOREACH_OBJLIST(BaseClassSubobj, child->parents, iter) {
-    if (hasAncestor(iter.data(), ancestor)) {
-      return true;
-    }
-  }
-
-  return false;
-}
-
-
 Variable *Scope::lookupVariable_inner
   (LookupSet &candidates, StringRef name, Env &env, LookupFlags flags)
 {
@@ -427,11 +415,11 @@ void Scope::lookupVariable_considerBase
       // 'v1' is hidden by 'v2' but (because of virtual inheritance)
       // 'v1' was nevertheless traversed before 'v2'.  So, check whether
       // 'v2' hides 'v1'.  See in/d0104.cc.
-      if (hasAncestor(v2Subobj, v1Subobj)) {
+      if (curCompound->subobjectHasAncestor(v2Subobj, v1Subobj)) {
         // ok, just go ahead and let 'v2' replace 'v1'
         TRACE("lookup", "DAG ancestor conflict suppressed (v2 is lower)");
       }
-      else if (hasAncestor(v1Subobj, v2Subobj)) {
+      else if (curCompound->subobjectHasAncestor(v1Subobj, v2Subobj)) {
         // it could also be the other way around
         TRACE("lookup", "DAG ancestor conflict suppressed (v1 is lower)");
 
@@ -668,15 +656,14 @@ void Scope::lookup(LookupSet &set, StringRef name, Env *env, LookupFlags flags)
   // get all the subobjects (I believe we do not have to call
   // ensureClassBodyInstantiated since every context will already
   // require that 'curCompound' be complete.)
-  SObjList<BaseClassSubobj const> subobjs;
-  curCompound->getSubobjects(subobjs);
+  std::vector<BaseClassSubobj const *> const &subobjs =
+    curCompound->getSubobjectsArray();
 
   // look in each one for 'name', keeping track of which subobject
   // we find it in, if any
   xassert(!v);
   BaseClassSubobj const *vObj = NULL;
-  SFOREACH_OBJLIST(BaseClassSubobj const, subobjs, iter) {
-    BaseClassSubobj const *v2Obj = iter.data();
+  for (BaseClassSubobj const *v2Obj : subobjs) {
     Variable *v2 = v2Obj->ct->lookupSingleVariable(name, flags);
     if (v2) {
       TRACE("lookup", "found " << v2Obj->ct->name << "::" << name);
@@ -689,11 +676,11 @@ void Scope::lookup(LookupSet &set, StringRef name, Env *env, LookupFlags flags)
         }
 
         // allow hidden entities (C++98 10.2 para 6)
-        if (hasAncestor(v2Obj, vObj)) {
+        if (curCompound->subobjectHasAncestor(v2Obj, vObj)) {
           // ok, just go ahead and let 'v2' replace 'v'
           TRACE("lookup", "DAG ancestor conflict suppressed (v2 is lower)");
         }
-        else if (hasAncestor(vObj, v2Obj)) {
+        else if (curCompound->subobjectHasAncestor(vObj, v2Obj)) {
           // it could also be the other way around
           TRACE("lookup", "DAG ancestor conflict suppressed (v is lower)");
 
@@ -847,6 +834,9 @@ void Scope::addUsingEdge(Scope *target)
 
   usingEdges.push(target);
   target->usingEdgesRefct++;
+
+  // invalidate all cached closures
+  s_usingGeneration++;
 }
 
 
@@ -934,14 +924,13 @@ void Scope::addUsingEdgeTransitively(Env &env, Scope *target)
   // get set of scopes that are reachable along "using" edges from
   // 'target'; all get active-using edges, as if they directly
   // appeared in a using-directive in this scope (7.3.4 para 2)
-  ArrayStack<Scope*> reachable;
   if (target != this) {
     // include it in the closure
-    reachable.push(target);
+    scheduleActiveUsingEdge(env, target);
   }
-  target->getUsingClosure(reachable);
 
   // all (transitive) "using" edges give rise to "active using" edges
+  ArrayStack<Scope*> const &reachable = target->getUsingClosure();
   for (int i=0; i<reachable.length(); i++) {
     scheduleActiveUsingEdge(env, reachable[i]);
   }
@@ -974,8 +963,22 @@ static void pushIfWhite(ArrayStack<Scope*> const &black,
   gray.push(s);
 }
 
+// set of scopes reachable from this one along "using" edges, not
+// including this one, in DFS order
+ArrayStack<Scope*> const &Scope::getUsingClosure()
+{
+  s_numUsingClosureQueries++;
+  if (m_usingClosureGeneration != s_usingGeneration) {
+    s_numUsingClosureComputations++;
+    m_usingClosure.empty();
+    computeUsingClosure(m_usingClosure);
+    m_usingClosureGeneration = s_usingGeneration;
+  }
+  return m_usingClosure;
+}
+
 // DFS over the network of using-directive edges
-void Scope::getUsingClosure(ArrayStack<Scope*> &dest)
+void Scope::computeUsingClosure(ArrayStack<Scope*> &dest)
 {
   // set of scopes already searched
   ArrayStack<Scope*> black;
@@ -1063,6 +1066,31 @@ Variable *Scope::searchActiveUsingEdges
 Variable *Scope::searchUsingEdges
   (LookupSet &candidates, StringRef name, Env &env, LookupFlags flags)
 {
+  // The DFS stops descending at scopes that have 'name', so in
+  // general its answer depends on the graph's shape.  But when at
+  // most one scope in the closure has the name, the DFS necessarily
+  // reaches it and finds nothing else, so the flat closure suffices.
+  {
+    ArrayStack<Scope*> const &closure = getUsingClosure();
+    Variable *only = lookupSingleVariable(name, flags);
+    int numFound = only? 1 : 0;
+    for (int i=0; i < closure.length() && numFound < 2; i++) {
+      Variable *v = closure[i]->lookupSingleVariable(name, flags);
+      if (v) {
+        only = v;
+        numFound++;
+      }
+    }
+
+    if (numFound < 2) {
+      s_numUsingEdgeFastLookups++;
+      if (only) {
+        candidates.adds(only);
+      }
+      return only;
+    }
+  }
+
   // set of scopes already searched
   ArrayStack<Scope*> black;
 
@@ -15,6 +15,7 @@
 #include "cc-flags.h"                  // AccessKeyword
 #include "cc-type-fwd.h"               // CompoundType, etc.
 #include "cc-type-visitor-fwd.h"       // TypeVisitor
+#include "live-count.h"                // LiveCount
 #include "lookupset.h"                 // LookupSet
 #include "serialno.h"                  // INHERIT_SERIAL_BASE
 #include "strmap.h"                    // StringRefMap
@@ -31,7 +32,7 @@
 
 // information about a single scope: the names defined in it,
 // any "current" things being built (class, function, etc.)
-class Scope INHERIT_SERIAL_BASE {
+class Scope INHERIT_SERIAL_BASE_AND private LiveCount<Scope> {
 private:     // types
   // for recording information about "active using" edges that
   // need to be cancelled at scope exit
@@ -136,6 +137,21 @@ public:      // data
   // retracted once this scope exits
   ArrayStack<ActiveEdgeRecord> outstandingActiveEdges;
 
+  // memo of 'computeUsingClosure', valid while
+  // 'm_usingClosureGeneration' equals 's_usingGeneration'
+  ArrayStack<Scope*> m_usingClosure;
+  unsigned m_usingClosureGeneration;
+
+  // bumped whenever a "using" edge is added anywhere, since that can
+  // change the closure of any scope
+  static unsigned s_usingGeneration;
+
+public:      // data
+  // statistics for -tr cacheStats
+  static unsigned long s_numUsingClosureQueries;
+  static unsigned long s_numUsingClosureComputations;
+  static unsigned long s_numUsingEdgeFastLookups;
+
   // ------------- "current" entities -------------------
   // these are set to allow the typechecking code to know about
   // the context we're in
@@ -164,7 +180,8 @@ private:     // funcs
      Env &env, LookupFlags flags, Variable *vfound);
   Variable *searchUsingEdges
     (LookupSet &candidates, StringRef name, Env &env, LookupFlags flags);
-  void getUsingClosure(ArrayStack<Scope*> &dest);
+  ArrayStack<Scope*> const &getUsingClosure();
+  void computeUsingClosure(ArrayStack<Scope*> &dest);
 
   // variant of 'lookup' that does not expand overload sets
   Variable *lookupSingleVariable(StringRef name, LookupFlags flags);
@@ -176,11 +193,16 @@ protected:   // funcs
   // maintaining 'dataMembers'
   virtual void afterAddVariable(Variable *v);
 
+  // record a change that does not go through 'addVariable', so that
+  // caches keyed by 'changeCount' notice it
+  void noteChange() { changeCount++; }
+
 public:      // funcs
   Scope(ScopeKind sk, int changeCount, SourceLoc initLoc);
   virtual ~Scope();     // virtual to silence warning; destructor is not part of virtualized interface
 
   int getChangeCount() const { return changeCount; }
+  bool isOnScopeStack() const { return onScopeStack; }
 
   // this is actually for debugging only ....
   int getNumVariables() const       { return variables.getNumEntries(); }
@@ -24,6 +24,7 @@
 #include "generic_amb.h"               // resolveAmbiguity, etc.
 #include "implconv.h"                  // test_getImplicitConversion
 #include "implint.h"                   // resolveImplIntAmbig
+#include "line-table.h"                // getSourceLocLine
 #include "mtype.h"                     // MType
 #include "overload.h"                  // resolveOverload
 #include "stdconv.h"                   // test_getStandardConversion
@@ -160,7 +161,7 @@ bool strongMsgFilter(ErrorMsg *msg)
   }
   else {
     // drop it
-    TRACE("error", "dropping error arising from uninst template: " << msg->msg);
+    TRACE("error", "dropping error arising from uninst template: " << msg->msg());
     return false;
   }
 }
@@ -416,7 +417,7 @@ void TF_namespaceDefn::itcheck(Env &env)
   Scope *s;
   if (existing) {
     // extend existing scope
-    s = existing->m_denotedScope;
+    s = existing->getDenotedScope();
   }
   else {
     // make new namespace
@@ -710,19 +711,19 @@ void Function::tcheckBody(Env &env)
   //
   // UPDATE: I've changed this invariant, as I need to point the
   // funcDefn at the definition even if the body has not been tchecked.
-  Function *&vfd = nameAndParams->var->funcDefn;
-  if (vfd) {
-    if (nameAndParams->var->hasFlag(DF_GNU_EXTERN_INLINE)) {
+  Variable *var = nameAndParams->var;
+  if (Function *vfd = var->getFuncDefn()) {
+    if (var->hasFlag(DF_GNU_EXTERN_INLINE)) {
       // we should not even get here if we are handling extern inlines
       // as prototypes as there is no function definition to override
       xassert(handleExternInline_asWeakStaticInline());
       // dsw: stomp on the old definition if it was an extern inline
-      vfd = this;
+      var->setFuncDefn(this);
     } else {
       xassert(vfd == this);
     }
   } else {
-    vfd = this;
+    var->setFuncDefn(this);
   }
 }
 
@@ -1406,7 +1407,8 @@ void PQ_qualifier::tcheck_pq(Env &env, Scope *scope, LookupFlags lflags)
       // t0248.cc tests a couple cases...
       bool hasVars = containsVariables(sargs);
       if (!hasVars &&
-          bareQualifierVar->templateInfo()->getSpecialization(sargs)) {
+          bareQualifierVar->templateInfo()->getSpecialization(sargs,
+            env.tfac.templateArgumentLists())) {
         // do not associate 'bareQualifier' with any template scope
       }
       else {
@@ -1686,6 +1688,11 @@ bool isBuggyGcc2HeaderDQT(Env &env, PQName *name)
 }
 
 
+static string noTypeCalledText(StringRef name)
+{
+  return stringc << "there is no type called '" << name << "'";
+}
+
 // 7.1.5.2
 Type *TS_name::itcheck(Env &env, Tcheck &tc)
 {
@@ -1762,6 +1769,12 @@ do_lookup:
     // error message in E_variable::itcheck is not marked as such, it
     // means we prefer to report the error as if the interpretation as
     // "variable" were the only one.
+    if (name->isPQ_name()) {
+      // common case; usually discarded by disambiguation, so defer
+      // building the message
+      return env.error(env.loc(), &noTypeCalledText, name->getName(),
+                       eflags);
+    }
     return env.error(stringc
       << "there is no type called '" << *name << "'", eflags);
   }
@@ -2032,7 +2045,8 @@ CompoundType *checkClasskeyAndName(
     }
 
     // does this specialization already exist?
-    Variable *spec = primaryTI->getSpecialization(*templateArgs);
+    Variable *spec = primaryTI->getSpecialization(*templateArgs,
+      env.tfac.templateArgumentLists());
     if (spec) {
       ct = spec->type->asCompoundType();
     }
@@ -2189,7 +2203,7 @@ CompoundType *checkClasskeyAndName(
       // 'makeNewCompound' will already have put the template *parameters*
       // into 'specialTI', but not the template arguments
       TemplateInfo *ctTI = ct->templateInfo();
-      ctTI->copyArguments(ssargs);
+      ctTI->copyArguments(ssargs, env.tfac.templateArgumentLists());
 
       // fix the self-type arguments (only if partial inst)
       if (ct->selfType->isPseudoInstantiation()) {
@@ -3377,7 +3391,7 @@ realStart:
                           scope, enclosingClass, prior, overloadSet);
 
   if (befriending) {
-    befriending->friends.prepend(ret);
+    befriending->addFriend(ret);
   }
 
   return ret;
@@ -3951,8 +3965,9 @@ void Declarator::mid_tcheck(Env &env, Tcheck &dt)
         env.error(getLoc(), "template primary cannot have template args");
       }
       else {
-        copyTemplateArgs(var->templateInfo()->arguments,
-                         getDeclaratorId()->asPQ_templateC()->sargs);
+        var->templateInfo()->copyArguments(
+          getDeclaratorId()->asPQ_templateC()->sargs,
+          env.tfac.templateArgumentLists());
       }
     }
   }
@@ -4124,11 +4139,8 @@ void Declarator::mid_tcheck(Env &env, Tcheck &dt)
             var->setFlag(DF_VIRTUAL);
             // this makes a set of all of the possible functions that
             // we override; please see the note at
-            // Variable::virtuallyOverride
-            if (!var->virtuallyOverride) {
-              var->virtuallyOverride = new SObjSet<Variable*>();
-            }
-            var->virtuallyOverride->add(var2);
+            // Variable::getVirtuallyOverride
+            var->addVirtuallyOverride(var2);
           }
         }
       }
@@ -6036,6 +6048,11 @@ E_fieldAcc *wrapWithImplicitThis(Env &env, Variable *var, PQName *name)
 }
 
 
+static string noVariableCalledText(StringRef name)
+{
+  return stringc << "there is no variable called '" << name << "'";
+}
+
 Type *E_variable::itcheck_x(Env &env, Expression *&replacement)
 {
   return itcheck_var(env, replacement, LF_NONE);
@@ -6136,6 +6153,10 @@ Type *E_variable::itcheck_var_set(Env &env, Expression *&replacement,
           // prompted by the need to allow template bodies to call
           // undeclared functions in a "dependent" context [C++98 14.6
           // para 8].  See the note in TS_name::itcheck.
+          if (name->isPQ_name()) {
+            return env.error(name->loc, &noVariableCalledText,
+                             name->getName(), EF_NONE);
+          }
           return env.error(name->loc, stringc
                            << "there is no variable called '" << *name << "'",
                            EF_NONE);
@@ -6860,6 +6881,30 @@ void possiblyWrapWithImplicitThis(Env &env, Expression *&func,
   }
 }
 
+// True if none of the argument types can have associated namespaces
+// or classes (3.4.2p2), in which case argument-dependent lookup would
+// find nothing.  This is the common case for calls that pass only
+// fundamental types and pointers or arrays of them, so checking it
+// lets such calls skip the lookup machinery.
+static bool allArgsLackAssociatedScopes(FakeList<ArgExpression> *args)
+{
+  FAKELIST_FOREACH(ArgExpression, args, iter) {
+    Type *t = iter->getType();
+    if (!t) {
+      return false;         // be conservative
+    }
+
+    t = t->asRval();
+    while (t->isPointerType() || t->isArrayType()) {
+      t = t->getAtType();
+    }
+    if (!t->isSimpleType()) {
+      return false;         // class, enum, function, etc.
+    }
+  }
+  return true;
+}
+
 Type *E_funCall::inner2_itcheck(Env &env, LookupSet &candidates)
 {
   // inner1 skipped E_groupings already
@@ -6942,7 +6987,8 @@ Type *E_funCall::inner2_itcheck(Env &env, LookupSet &candidates)
     if (fevar &&                                // E_variable,
         !pqname->hasQualifiers() &&             // unqualified,
         (fevar->type->isSimple(ST_NOTFOUND) ||  // orig lookup failed
-         !fevar->var->isClassMember())) {       //   or found a nonmember
+         !fevar->var->isClassMember()) &&       //   or found a nonmember
+        !allArgsLackAssociatedScopes(args)) {   // and it could find something
       // get additional candidates from associated scopes
       ArrayStack<Type*> argTypes(fl_count(args));
       FAKELIST_FOREACH(ArgExpression, args, iter) {
@@ -7352,7 +7398,7 @@ static Type *internalTestingHooks
           hasNamedFunction(fl_first(args)->expr->asE_funCall()->func)) {
         // resolution yielded a function call
         Variable *chosen = getNamedFunction(fl_first(args)->expr->asE_funCall()->func);
-        int actualLine = sourceLocManager->getLine(chosen->loc);
+        int actualLine = getSourceLocLine(chosen->loc);
         if (expectLine != actualLine) {
           env.error(stringc
             << "expected overload to choose function on line "
@@ -7402,11 +7448,11 @@ static Type *internalTestingHooks
           hasNamedFunction(fl_first(args)->expr->asE_funCall()->func)) {
         // resolution yielded a function call
         Variable *chosen = getNamedFunction(fl_first(args)->expr->asE_funCall()->func);
-        if (!chosen->funcDefn) {
+        if (!chosen->getFuncDefn()) {
           env.error("expected to be calling a defined function");
         }
         else {
-          int actualLine = sourceLocManager->getLine(chosen->funcDefn->getLoc());
+          int actualLine = getSourceLocLine(chosen->getFuncDefn()->getLoc());
           if (expectLine != actualLine) {
             env.error(stringc
               << "expected to call function on line "
@@ -7990,7 +8036,7 @@ Type *E_fieldAcc::itcheck_fieldAcc_set(Env &env, LookupFlags flags,
         << "a class or namespace, not " << kindAndType(firstQVar1));
     }
     Scope *firstQScope1 = (!firstQVar1)?             NULL :
-                          firstQVar1->isNamespace()? firstQVar1->m_denotedScope :
+                          firstQVar1->isNamespace()? firstQVar1->getDenotedScope() :
                                                      firstQVar1->type->asCompoundType();
 
     // lookup of firstQ in scope of LHS class
@@ -11024,7 +11070,7 @@ void TP_type::itcheck(Env &env, int&)
                                DF_TYPEDEF | DF_TEMPL_PARAM);
   tvar->typedefVar = var;
   if (defaultType) {
-    var->defaultParamType = defaultType->getType();
+    var->setDefaultParamType(defaultType->getType());
   }
 
   // if the default argument had an error, then do not add anything to
@@ -11120,7 +11166,7 @@ void ND_alias::tcheck(Env &env)
     // 7.3.2 para 3: redefinitions are allowed only if they make it
     // refer to the same thing
     if (existing->isNamespace() &&
-        existing->m_denotedScope == origVar->m_denotedScope) {
+        existing->getDenotedScope() == origVar->getDenotedScope()) {
       return;     // ok; nothing needs to be done
     }
     else {
@@ -11136,7 +11182,7 @@ void ND_alias::tcheck(Env &env)
   env.addVariable(v);
 
   // make it refer to the same namespace as the original one
-  v->m_denotedScope = origVar->m_denotedScope;
+  v->setNamespaceScope(origVar->getDenotedScope());
 
   // note that, if one cares to, the alias can be distinguished from
   // the original name in that the scope's 'namespaceVar' still points
@@ -11222,7 +11268,7 @@ void ND_usingDir::tcheck(Env &env)
     return;
   }
   xassert(targetVar->isNamespace());   // meaning of LF_ONLY_NAMESPACES
-  Scope *target = targetVar->m_denotedScope;
+  Scope *target = targetVar->getDenotedScope();
 
   // to implement transitivity of 'using namespace', add a "using"
   // edge from the current scope to the target scope, if the current
@@ -26,13 +26,14 @@
 
 // smbase
 #include "hashtbl.h"                   // lcprngTwoSteps
+#include "owner.h"                     // Owner
 #include "sm-stdint.h"                 // uintptr_t
-#include "sobjset.h"                   // SObjSet
 #include "strutil.h"                   // copyToStaticBuffer
 #include "trace.h"                     // tracingSys
 
 // libc++
 #include <algorithm>                   // std::max
+#include <utility>                     // std::make_pair
 
 // libc
 #include <stdlib.h>                    // getenv
@@ -47,17 +48,23 @@ bool printAnonComment = false;
 
 
 // ------------------ AtomicType -----------------
-ALLOC_STATS_DEFINE(AtomicType)
+#if ELSA_OBJECT_COUNTS
+  ALLOC_STATS_DEFINE(AtomicType)
+#endif
 
 AtomicType::AtomicType()
 {
-  ALLOC_STATS_IN_CTOR
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_IN_CTOR
+  #endif
 }
 
 
 AtomicType::~AtomicType()
 {
-  ALLOC_STATS_IN_DTOR
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_IN_DTOR
+  #endif
 }
 
 
@@ -255,6 +262,137 @@ string BaseClassSubobj::canonName() const
 }
 
 
+// ------------------ ClassLayout -----------------
+unsigned long ClassLayout::s_numQueries = 0;
+unsigned long ClassLayout::s_numComputed = 0;
+
+
+ClassLayout::ClassLayout(TypeSizes const &typeSizes)
+  : m_typeSizes(&typeSizes),
+    m_size(0),
+    m_align(1),
+    m_dataMemberOffsets(),
+    m_baseOffsets(),
+    m_stable(false)
+{}
+
+
+string ClassLayout::toString(CompoundType const *ct) const
+{
+  stringBuilder sb;
+  sb << "layout of " << ct->keywordAndName()
+     << ": size " << m_size << ", align " << m_align
+     << (m_stable? "" : " (unstable)") << "\n";
+
+  for (auto const &base : m_baseOffsets) {
+    sb << "  base " << base.first->ct->keywordAndName()
+       << (base.first->isVirtual? " (virtual)" : "")
+       << " at " << base.second << "\n";
+  }
+
+  int index = 0;
+  SFOREACH_OBJLIST(Variable, ct->dataMembers, iter) {
+    Variable const *v = iter.data();
+    sb << "  " << v->toString() << " at " << m_dataMemberOffsets[index] << "\n";
+    index++;
+  }
+
+  return sb;
+}
+
+
+STATICDEF void ClassLayout::printStats(ostream &os)
+{
+  os << "class layout queries: " << s_numQueries << "\n"
+     << "class layouts computed: " << s_numComputed << "\n";
+}
+
+
+// --------------- ClassHierarchyIndex ------------
+unsigned long ClassHierarchyIndex::s_numBuilt = 0;
+
+
+// Add 'subobj' and its parents to 'index', depth first, skipping any
+// already present.  This yields the same order as the 'visited'-based
+// traversal used elsewhere, but does not disturb the 'visited' flags,
+// since the index may be built in the middle of such a traversal.
+static void collectSubobjects(ClassHierarchyIndex &index,
+                              BaseClassSubobj const *subobj)
+{
+  if (index.m_subobjectIndex.find(subobj) != index.m_subobjectIndex.end()) {
+    return;
+  }
+  index.m_subobjectIndex[subobj] = (int)index.m_subobjects.size();
+  index.m_subobjects.push_back(subobj);
+
+  SFOREACH_OBJLIST(BaseClassSubobj, subobj->parents, iter) {
+    collectSubobjects(index, iter.data());
+  }
+}
+
+
+// Mark in 'dest' all subobjects reachable from 'subobj'.
+static void markAncestors(std::vector<bool> &dest,
+                          ClassHierarchyIndex const &index,
+                          BaseClassSubobj const *subobj)
+{
+  int i = index.m_subobjectIndex.find(subobj)->second;
+  if (dest[i]) {
+    return;
+  }
+  dest[i] = true;
+
+  SFOREACH_OBJLIST(BaseClassSubobj, subobj->parents, iter) {
+    markAncestors(dest, index, iter.data());
+  }
+}
+
+
+ClassHierarchyIndex::ClassHierarchyIndex(CompoundType const *ct)
+  : m_subobjects(),
+    m_subobjectIndex(),
+    m_ancestors(),
+    m_subobjectCounts(),
+    m_virtualBases()
+{
+  collectSubobjects(*this, &(ct->subobj));
+
+  int n = (int)m_subobjects.size();
+  m_ancestors.resize(n);
+  for (int i=0; i < n; i++) {
+    BaseClassSubobj const *subobj = m_subobjects[i];
+
+    m_ancestors[i].resize(n, false);
+    markAncestors(m_ancestors[i], *this, subobj);
+
+    m_subobjectCounts[subobj->ct]++;
+  }
+
+  FOREACH_OBJLIST(BaseClassSubobj, ct->virtualBases, iter) {
+    m_virtualBases[iter.data()->ct] = iter.data();
+  }
+
+  s_numBuilt++;
+}
+
+
+int ClassHierarchyIndex::subobjectCount(CompoundType const *ct) const
+{
+  auto it = m_subobjectCounts.find(ct);
+  return it == m_subobjectCounts.end()? 0 : it->second;
+}
+
+
+bool ClassHierarchyIndex::hasAncestor(BaseClassSubobj const *child,
+                                      BaseClassSubobj const *ancestor) const
+{
+  auto c = m_subobjectIndex.find(child);
+  auto a = m_subobjectIndex.find(ancestor);
+  xassert(c != m_subobjectIndex.end() && a != m_subobjectIndex.end());
+  return m_ancestors[c->second][a->second];
+}
+
+
 // ------------------ CompoundType -----------------
 CompoundType::CompoundType(Keyword k, StringRef n)
   : NamedAtomicType(n),
@@ -270,7 +408,11 @@ CompoundType::CompoundType(Keyword k, StringRef n)
     instName(n),
     syntax(NULL),
     parameterizingScope(NULL),
-    selfType(NULL)
+    selfType(NULL),
+    m_layout(NULL),
+    m_hierarchyIndex(NULL),
+    m_hasAnonymousCompoundMembers(false),
+    m_hasFinishedDefinition(false)
 {
   curCompound = this;
   curAccess = (k==K_CLASS? AK_PRIVATE : AK_PUBLIC);
@@ -278,6 +420,9 @@ CompoundType::CompoundType(Keyword k, StringRef n)
 
 CompoundType::~CompoundType()
 {
+  delete m_layout;
+  delete m_hierarchyIndex;
+
   //bases.deleteAll();    // automatic, and I'd need a cast to do it explicitly because it's 'const' now
   if (templateInfo()) {
     delete templateInfo();
@@ -421,20 +566,71 @@ string CompoundType::toCString() const
 }
 
 
+// True if the size of 't' is final, i.e., it does not contain by
+// value any class whose layout could still change.
+static bool typeHasStableLayout(Type const *t)
+{
+  t = t->skipTypedefsC();
+  while (t->isArrayType()) {
+    t = t->asArrayTypeC()->eltType->skipTypedefsC();
+  }
+
+  if (CompoundType const *ct = t->ifCompoundTypeC()) {
+    return ct->hasStableLayout();
+  }
+
+  return true;
+}
+
+
 int CompoundType::reprSize(TypeSizes const &typeSizes) const
 {
+  return getLayout(typeSizes).m_size;
+}
+
+
+ClassLayout const &CompoundType::getLayout(TypeSizes const &typeSizes) const
+{
+  ClassLayout::s_numQueries++;
+
+  if (m_layout &&
+      m_layout->m_stable &&
+      m_layout->m_typeSizes == &typeSizes) {
+    return *m_layout;
+  }
+
+  // Compute into a fresh object so that, if XReprSize is thrown, the
+  // previous layout is left alone.
+  Owner<ClassLayout> layout(new ClassLayout(typeSizes));
+  computeLayout(*layout);
+  ClassLayout::s_numComputed++;
+
+  TRACE("layout", layout->toString(this));
+
+  delete m_layout;
+  m_layout = layout.xfr();
+  return *m_layout;
+}
+
+
+void CompoundType::computeLayout(ClassLayout &layout) const
+{
+  TypeSizes const &typeSizes = *(layout.m_typeSizes);
+  layout.m_stable = isComplete();
+
   int total = 0;
 
   // base classes
-  {
-    SObjList<BaseClassSubobj const> subobjs;
-    getSubobjects(subobjs);
-    SFOREACH_OBJLIST(BaseClassSubobj const, subobjs, iter) {
-      if (iter.data()->ct == this) {
-        // skip my own subobject, as that will be accounted for below
-      }
-      else {
-        total += iter.data()->ct->reprSize(typeSizes);
+  for (BaseClassSubobj const *subobj : getSubobjectsArray()) {
+    if (subobj->ct == this) {
+      // skip my own subobject, as that will be accounted for below
+    }
+    else {
+      CompoundType const *baseCT = subobj->ct;
+      layout.m_baseOffsets.push_back(std::make_pair(subobj, total));
+      total += baseCT->reprSize(typeSizes);
+      if (!baseCT->hasStableLayout()) {
+        layout.m_stable = false;
       }
     }
   }
@@ -461,16 +657,40 @@ int CompoundType::reprSize(TypeSizes const &typeSizes) const
   int bytes = 0;       // unaligned bytes
   int align = 1;       // prevailing alignment in bytes
 
+  // Offset of the next data member, as reported by
+  // 'getDataMemberOffset'.  This is simply the sum of the sizes of
+  // the preceding members.
+  int nextOffset = 0;
+
   // data members
+  layout.m_dataMemberOffsets.reserve(dataMembers.count());
   SFOREACH_OBJLIST(Variable, dataMembers, iter) {
     Variable const *v = iter.data();
 
+    if (v->type->isArrayTypeWithUnspecifiedSize()) {
+      // "open array"; there are checks elsewhere that control whether
+      // Elsa allows this, this at point in the code I can just assume
+      // that they are allowed; they are treated as having size 0, so
+      // just skip it (in/c/dC0032.c)
+      layout.m_dataMemberOffsets.push_back(keyword == K_UNION? 0 : nextOffset);
+      continue;
+    }
+
+    int membSize = v->type->reprSize(typeSizes);
+    if (!typeHasStableLayout(v->type)) {
+      layout.m_stable = false;
+    }
+
     if (keyword == K_UNION) {
       // representation size is max over field sizes
-      total = std::max(total, v->type->reprSize(typeSizes));
+      layout.m_dataMemberOffsets.push_back(0);
+      total = std::max(total, membSize);
       continue;
     }
 
+    layout.m_dataMemberOffsets.push_back(nextOffset);
+    nextOffset += membSize;
+
     if (v->isBitfield()) {
       // consolidate bytes as bits
       bits += bytes*8;
@@ -494,16 +714,6 @@ int CompoundType::reprSize(TypeSizes const &typeSizes) const
       bits = 0;
     }
 
-    if (v->type->isArrayTypeWithUnspecifiedSize()) {
-      // "open array"; there are checks elsewhere that control whether
-      // Elsa allows this, this at point in the code I can just assume
-      // that they are allowed; they are treated as having size 0, so
-      // just skip it (in/c/dC0032.c)
-      continue;
-    }
-
-    int membSize = v->type->reprSize(typeSizes);
-
     if (membSize >= align) {
       // increase alignment if necessary, up to 4 bytes;
       // this is wrong because you can't tell the alignment
@@ -535,7 +745,16 @@ int CompoundType::reprSize(TypeSizes const &typeSizes) const
   bits += bytes*8;
   total += ((bits + (align*8-1)) / (align*8)) * align;
 
-  return total;
+  layout.m_size = total;
+  layout.m_align = align;
+}
+
+
+void CompoundType::invalidateLayout()
+{
+  if (m_layout) {
+    m_layout->m_stable = false;
+  }
 }
 
 
@@ -584,6 +803,10 @@ void CompoundType::addField(Variable *v)
     // Add it to the data members as well so that Elsa clients can easily
     // see that there is a nested member here.
     dataMembers.append(v);
+    invalidateLayout();
+    if (v->type->isCompoundType()) {
+      m_hasAnonymousCompoundMembers = true;
+    }
     TRACE("anon-comp", stringb(
       "Added anonymous member declared at " << toLCString(v->loc) <<
       " to container '" << toString() << "'."));
@@ -597,6 +820,7 @@ void CompoundType::afterAddVariable(Variable *v)
   if (!v->type->isFunctionType() &&
       !(v->flags & (DF_STATIC | DF_TYPEDEF | DF_ENUMERATOR | DF_USING_ALIAS))) {
     dataMembers.append(v);
+    invalidateLayout();
   }
 }
 
@@ -658,14 +882,15 @@ string CompoundType::dataMembersToString() const
 int CompoundType::getDataMemberOffset(
   TypeSizes const &typeSizes, Variable const *dataMember) const
 {
-  int offset = 0;
+  ClassLayout const &layout = getLayout(typeSizes);
+
+  int index = 0;
   SFOREACH_OBJLIST(Variable, dataMembers, iter) {
     if (iter.data() == dataMember) {
-      return offset;
+      // TODO: This does not take padding for alignment into account.
+      return layout.m_dataMemberOffsets[index];
     }
-
-    // TODO: This does not take padding for alignment into account.
-    offset += iter.data()->type->reprSize(typeSizes);
+    index++;
   }
 
   xfailure_stringbc("getDataMemberOffset: no such member: "
@@ -681,6 +906,10 @@ void CompoundType::addBaseClass(BaseClass * /*owner*/ newBase)
   // add the new base; override 'const' so we can modify the list
   // (this is the one function allowed to do this)
   const_cast<ObjList<BaseClass>&>(bases).append(newBase);
+  invalidateLayout();
+
+  delete m_hierarchyIndex;
+  m_hierarchyIndex = NULL;
 
   // replicate 'newBase's inheritance hierarchy in the subobject
   // hierarchy, representing virtual inheritance with explicit sharing
@@ -788,24 +1017,28 @@ void CompoundType::getSubobjects(SObjList<BaseClassSubobj const> &dest) const
   // already on the list, so those won't change order
   dest.reverse();
 
-  clearSubobjVisited();
-  getSubobjects_helper(dest, &subobj);
+  for (BaseClassSubobj const *subobj : getSubobjectsArray()) {
+    dest.prepend(subobj);
+  }
 
   // reverse the list since it was constructed in reverse order
   dest.reverse();
 }
 
-STATICDEF void CompoundType::getSubobjects_helper
-  (SObjList<BaseClassSubobj const> &dest, BaseClassSubobj const *subobj)
+
+ClassHierarchyIndex const &CompoundType::getHierarchyIndex() const
 {
-  if (subobj->visited) return;
-  subobj->visited = true;
+  if (!m_hierarchyIndex) {
+    m_hierarchyIndex = new ClassHierarchyIndex(this);
+  }
+  return *m_hierarchyIndex;
+}
 
-  dest.prepend(subobj);
 
-  SFOREACH_OBJLIST(BaseClassSubobj, subobj->parents, iter) {
-    getSubobjects_helper(dest, iter.data());
-  }
+bool CompoundType::hasVirtualBase(CompoundType const *ct) const
+{
+  ClassHierarchyIndex const &index = getHierarchyIndex();
+  return index.m_virtualBases.find(ct) != index.m_virtualBases.end();
 }
 
 
@@ -857,14 +1090,10 @@ string toString(CompoundType::Keyword k)
 
 int CompoundType::countBaseClassSubobjects(CompoundType const *ct) const
 {
-  SObjList<BaseClassSubobj const> objs;
-  getSubobjects(objs);
+  int count = getHierarchyIndex().subobjectCount(ct);
 
-  int count = 0;
-  SFOREACH_OBJLIST(BaseClassSubobj const, objs, iter) {
-    if (iter.data()->ct == ct) {
-      count++;
-    }
+  if (!m_hasAnonymousCompoundMembers) {
+    return count;
   }
 
   // Count anonymous compound members as being subobjects for this,
@@ -888,16 +1117,6 @@ int CompoundType::countBaseClassSubobjects(CompoundType const *ct) const
 }
 
 
-// simple recursive computation
-void getBaseClasses(SObjSet<CompoundType*> &bases, CompoundType *ct)
-{
-  bases.add(ct);
-
-  FOREACH_OBJLIST(BaseClass, ct->bases, iter) {
-    getBaseClasses(bases, iter.data()->ct);
-  }
-}
-
 STATICDEF CompoundType *CompoundType::lub
   (CompoundType *t1, CompoundType *t2, bool &wasAmbig)
 {
@@ -908,23 +1127,21 @@ STATICDEF CompoundType *CompoundType::lub
     return t1;
   }
 
-  // compute the set of base classes for each class
-  SObjSet<CompoundType*> t1Bases, t2Bases;
-  getBaseClasses(t1Bases, t1);
-  getBaseClasses(t2Bases, t2);
+  // The intersection of the sets of base classes is the set of
+  // classes that have subobjects in both 't1' and 't2'.
+  ClassHierarchyIndex const &t1Index = t1->getHierarchyIndex();
+  ClassHierarchyIndex const &t2Index = t2->getHierarchyIndex();
 
   // look for an element in the intersection that has nothing below it
-  // (hmm.. this will be quadratic due to linear-time 'hasBaseClass'...)
-  CompoundType *least = NULL;
-  {
-    for (SObjSetIter<CompoundType*> iter(t1Bases); !iter.isDone(); iter.adv()) {
-      if (!t2Bases.contains(iter.data())) continue;       // filter for intersection
-
-      if (!least ||
-          iter.data()->hasBaseClass(least)) {
-        // new least
-        least = iter.data();
-      }
+  CompoundType const *least = NULL;
+  for (auto const &entry : t1Index.m_subobjectCounts) {
+    CompoundType const *ct = entry.first;
+    if (!t2Index.subobjectCount(ct)) continue;      // filter for intersection
+
+    if (!least ||
+        ct->hasBaseClass(least)) {
+      // new least
+      least = ct;
     }
   }
 
@@ -933,10 +1150,11 @@ STATICDEF CompoundType *CompoundType::lub
   }
 
   // check that it's the unique least
-  for (SObjSetIter<CompoundType*> iter(t1Bases); !iter.isDone(); iter.adv()) {
-    if (!t2Bases.contains(iter.data())) continue;       // filter for intersection
+  for (auto const &entry : t1Index.m_subobjectCounts) {
+    CompoundType const *ct = entry.first;
+    if (!t2Index.subobjectCount(ct)) continue;      // filter for intersection
 
-    if (least->hasBaseClass(iter.data())) {
+    if (least->hasBaseClass(ct)) {
       // least is indeed less than (or equal to) this one
     }
     else {
@@ -947,11 +1165,26 @@ STATICDEF CompoundType *CompoundType::lub
   }
 
   // good to go
-  return least;
+  return const_cast<CompoundType*>(least);
 }
 
 
 void CompoundType::finishedClassDefinition(StringRef specialName)
+{
+  m_hasFinishedDefinition = true;
+
+  finishedClassDefinition_conversions(specialName);
+
+  // index them by what they yield
+  m_conversionOperatorIndex.clear();
+  SFOREACH_OBJLIST_NC(Variable, conversionOperators, iter) {
+    Variable *v = iter.data();
+    m_conversionOperatorIndex.push_back(ConversionOperatorEntry(v,
+      classifyConversionType(v->type->asFunctionTypeC()->retType)));
+  }
+}
+
+void CompoundType::finishedClassDefinition_conversions(StringRef specialName)
 {
   // get inherited conversions
   FOREACH_OBJLIST(BaseClass, bases, iter) {
@@ -1003,6 +1236,63 @@ void CompoundType::addLocalConversionOp(Variable *op)
 }
 
 
+void CompoundType::getConversionOperators(ArrayStack<Variable*> &dest,
+                                          ConversionOperatorKind kinds) const
+{
+  if (!m_hasFinishedDefinition) {
+    SFOREACH_OBJLIST_NC(Variable, conversionOperators, iter) {
+      dest.push(iter.data());
+    }
+    return;
+  }
+
+  for (ConversionOperatorEntry const &e : m_conversionOperatorIndex) {
+    if (e.m_kind & kinds) {
+      dest.push(e.m_var);
+    }
+  }
+}
+
+
+ConversionOperatorKind classifyConversionType(Type const *retType)
+{
+  ConversionOperatorKind ret =
+    retType->isReference()? COK_REFERENCE : COK_NONE;
+
+  Type const *t = retType->asRvalC();
+  if (t->containsVariables()) {
+    ret |= COK_TEMPLATE;
+  }
+  else if (t->isCompoundType()) {
+    ret |= COK_CLASS;
+  }
+  else if (t->isEnumType() ||
+           (t->isSimpleType() && isArithmeticType(t->asSimpleTypeC()->type))) {
+    ret |= COK_ARITHMETIC;
+  }
+  else if (t->isPointerType() ||
+           t->isPointerToMemberType() ||
+           t->isArrayType() ||
+           t->isFunctionType()) {
+    ret |= COK_POINTER;
+  }
+  else {
+    ret |= COK_OTHER;
+  }
+
+  return ret;
+}
+
+
+void CompoundType::addFriend(Variable *v)
+{
+  friends.prepend(v);
+
+  // arg-dep lookup in this scope finds friends
+  noteChange();
+}
+
+
 // return false if the presence of 'v' in a CompoundType
 // prevents that compound from being "aggregate"
 static bool isAggregate_one(Variable const *v)
@@ -1149,19 +1439,25 @@ bool StatelessTypePred::operator() (Type const *t)
 
 
 // -------------------- BaseType ----------------------
-ALLOC_STATS_DEFINE(BaseType)
+#if ELSA_OBJECT_COUNTS
+  ALLOC_STATS_DEFINE(BaseType)
+#endif
 
 bool BaseType::printAsML = false;
 
 
 BaseType::BaseType()
 {
-  ALLOC_STATS_IN_CTOR
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_IN_CTOR
+  #endif
 }
 
 BaseType::~BaseType()
 {
-  ALLOC_STATS_IN_DTOR
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_IN_DTOR
+  #endif
 }
 
 
@@ -1205,9 +1501,24 @@ Type const *BaseType::skipTypedefsC() const
 
 bool BaseType::equals(BaseType const *obj, MatchFlags flags) const
 {
+  Type const *t1 = baseTypeToType(this);
+  Type const *t2 = baseTypeToType(obj);
+
+  TypeEqualityCache *cache = TypeEqualityCache::active();
+  bool cacheable = false, result;
+  if (cache &&
+      cache->lookup(t1, t2, flags, TypeEqualityCache::K_MATCH_TYPE,
+                    cacheable, result)) {
+    return result;
+  }
+
   MType mtype;
-  return mtype.matchType(baseTypeToType(this),
-                         baseTypeToType(obj), flags);
+  result = mtype.matchType(t1, t2, flags);
+
+  if (cacheable) {
+    cache->insert(t1, t2, flags, TypeEqualityCache::K_MATCH_TYPE, result);
+  }
+  return result;
 }
 
 unsigned BaseType::hashValue() const
@@ -2665,6 +2976,16 @@ string TemplateParams::paramsToMLString() const
 
 
 // ---------------------- TypeFactory ---------------------
+TypeFactory::TypeFactory()
+  : m_templateArgumentLists(new TemplateArgumentListTable)
+{}
+
+TypeFactory::~TypeFactory()
+{
+  delete m_templateArgumentLists;
+}
+
+
 CompoundType *TypeFactory::makeCompoundType
   (CompoundType::Keyword keyword, StringRef name)
 {
@@ -2949,6 +3270,61 @@ CVAtomicType BasicTypeFactory::unqualifiedSimple[NUM_SIMPLE_TYPES] = {
 };
 
 
+BasicTypeFactory::BasicTypeFactory()
+  : m_compact(false),
+    m_cvAtomicPool(),
+    m_pointerPool(),
+    m_referencePool(),
+    m_functionPool(),
+    m_arrayPool(),
+    m_ptmPool()
+{}
+
+
+BasicTypeFactory::~BasicTypeFactory()
+{}
+
+
+// Bytes glibc's malloc would use for an 'n'-byte object on a 64-bit
+// host: an 8-byte header, rounded up to 16, at least 32.  This is
+// only an estimate for other allocators.
+static size_t mallocChunkSize(size_t n)
+{
+  size_t chunk = (n + 8 + 15) & ~(size_t)15;
+  return chunk < 32? 32 : chunk;
+}
+
+
+void BasicTypeFactory::printStats(ostream &os) const
+{
+  if (!m_compact) {
+    return;
+  }
+
+  // compare what the pools reserved (including unused space at the
+  // end of each last chunk) with what allocating the same objects
+  // one at a time would have cost
+  size_t totalReserved = 0;
+  size_t totalMalloc = 0;
+
+  #define POOL_STAT(pool, T)                                 \
+    os << "pooled " #T ": " << pool.size()                   \
+       << " (" << pool.bytesReserved() << " bytes reserved)\n";   \
+    totalReserved += pool.bytesReserved();                   \
+    totalMalloc += pool.size() * mallocChunkSize(sizeof(T));
+  POOL_STAT(m_cvAtomicPool, CVAtomicType)
+  POOL_STAT(m_pointerPool, PointerType)
+  POOL_STAT(m_referencePool, ReferenceType)
+  POOL_STAT(m_functionPool, FunctionType)
+  POOL_STAT(m_arrayPool, ArrayType)
+  POOL_STAT(m_ptmPool, PointerToMemberType)
+  #undef POOL_STAT
+
+  os << "pooled type bytes: " << totalReserved
+     << " (individually allocated, about " << totalMalloc << ")\n";
+}
+
+
 CVAtomicType *BasicTypeFactory::makeCVAtomicType(AtomicType *atomic, CVFlags cv)
 {
   // dsw: we now need to avoid this altogether since in
@@ -2966,24 +3342,40 @@ CVAtomicType *BasicTypeFactory::makeCVAtomicType(AtomicType *atomic, CVFlags cv)
 //    }
 //  #endif
 
+  if (m_compact) {
+    return m_cvAtomicPool.commit(
+      new (m_cvAtomicPool.reserve()) CVAtomicType(atomic, cv));
+  }
   return new CVAtomicType(atomic, cv);
 }
 
 
 PointerType *BasicTypeFactory::makePointerType(CVFlags cv, Type *atType)
 {
+  if (m_compact) {
+    return m_pointerPool.commit(
+      new (m_pointerPool.reserve()) PointerType(cv, atType));
+  }
   return new PointerType(cv, atType);
 }
 
 
 Type *BasicTypeFactory::makeReferenceType(Type *atType)
 {
+  if (m_compact) {
+    return m_referencePool.commit(
+      new (m_referencePool.reserve()) ReferenceType(atType));
+  }
   return new ReferenceType(atType);
 }
 
 
 FunctionType *BasicTypeFactory::makeFunctionType(Type *retType)
 {
+  if (m_compact) {
+    return m_functionPool.commit(
+      new (m_functionPool.reserve()) FunctionType(retType));
+  }
   return new FunctionType(retType);
 }
 
@@ -2993,6 +3385,10 @@ void BasicTypeFactory::doneParams(FunctionType *)
 
 ArrayType *BasicTypeFactory::makeArrayType(Type *eltType, int size)
 {
+  if (m_compact) {
+    return m_arrayPool.commit(
+      new (m_arrayPool.reserve()) ArrayType(eltType, size));
+  }
   return new ArrayType(eltType, size);
 }
 
@@ -3000,6 +3396,10 @@ ArrayType *BasicTypeFactory::makeArrayType(Type *eltType, int size)
 PointerToMemberType *BasicTypeFactory::makePointerToMemberType
   (NamedAtomicType *inClassNAT, CVFlags cv, Type *atType)
 {
+  if (m_compact) {
+    return m_ptmPool.commit(
+      new (m_ptmPool.reserve()) PointerToMemberType(inClassNAT, cv, atType));
+  }
   return new PointerToMemberType(inClassNAT, cv, atType);
 }
 
@@ -33,6 +33,8 @@
 #include "cc-flags.h"                  // CVFlags, DeclFlags, SimpleTypeId
 #include "cc-scope.h"                  // Scope
 #include "cc-type-visitor-fwd.h"       // TypeVisitor
+#include "typed-pool.h"                // TypedPool
+#include "live-count.h"                // LiveCount, ELSA_OBJECT_COUNTS
 #include "mflags.h"                    // MatchFlags
 #include "mtype-fwd.h"                 // MType
 #include "template-fwd.h"              // STemplateArgument, etc.
@@ -40,16 +42,24 @@
 #include "variable-fwd.h"              // Variable
 
 // smbase
+#include "array.h"                     // ArrayStack
 #include "astlist.h"                   // ASTList
 #include "exc.h"                       // XBase
 #include "objlist.h"                   // ObjList
 #include "serialno.h"                  // INHERIT_SERIAL_BASE
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
+#include "sm-ostream.h"                // ostream
 #include "sobjlist.h"                  // SObjList
 #include "srcloc.h"                    // SourceLoc
 #include "str.h"                       // string
 #include "strobjdict.h"                // StringObjDict
 #include "strtable.h"                  // StringRef
 
+// libc++
+#include <unordered_map>               // std::unordered_map
+#include <utility>                     // std::pair
+#include <vector>                      // std::vector
+
 
 // --------------------- atomic types --------------------------
 // interface to types that are atomic in the sense that no
@@ -122,7 +132,9 @@ public:     // funcs
   // toString()+newline to cout
   void gdb() const;
 
-  ALLOC_STATS_DECLARE
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_DECLARE
+  #endif
 };
 
 
@@ -133,7 +145,7 @@ string toString(AtomicType const *at);
 
 // represents one of C's built-in types;
 // there are exactly as many of these objects as there are built-in types
-class SimpleType : public AtomicType {
+class SimpleType : public AtomicType, private LiveCount<SimpleType> {
 public:     // data
   SimpleTypeId const type;
 
@@ -231,6 +243,131 @@ public:
   void traverse(TypeVisitor &vis);
 };
 
+// The result of laying out a CompoundType for a particular TypeSizes.
+// These are computed and cached by CompoundType::getLayout.
+class ClassLayout {
+public:      // data
+  // The sizes that were used to compute this layout.
+  TypeSizes const *m_typeSizes;        // (serf)
+
+  // The value of CompoundType::reprSize.
+  int m_size;
+
+  // Alignment, in bytes, that was used to pad 'm_size'.
+  int m_align;
+
+  // Offset in bytes of each element of 'dataMembers', in the same
+  // order.  Like the layout algorithm itself, this is approximate;
+  // in particular, it does not account for base class subobjects or
+  // alignment padding.
+  std::vector<int> m_dataMemberOffsets;
+
+  // Offset of each proper base class subobject, in the order returned
+  // by 'getSubobjects'.
+  std::vector<std::pair<BaseClassSubobj const *, int> > m_baseOffsets;
+
+  // True if the layout cannot change anymore, because the class and
+  // everything it contains by value are complete.  Unstable layouts
+  // are recomputed on each query.
+  bool m_stable;
+
+public:      // class data
+  // Number of 'getLayout' calls, and how many of them had to compute
+  // a new layout.
+  static unsigned long s_numQueries;
+  static unsigned long s_numComputed;
+
+public:      // methods
+  ClassLayout(TypeSizes const &typeSizes);
+
+  // Describe the layout on multiple lines, for "-tr layout".
+  string toString(CompoundType const *ct) const;
+
+  // Print the statistics.
+  static void printStats(ostream &os);
+};
+
+
+// Flattened view of the subobject hierarchy of one CompoundType,
+// answering the common inheritance queries without walking the
+// hierarchy.  Computed and cached by CompoundType::getHierarchyIndex.
+class ClassHierarchyIndex {
+public:      // data
+  // All subobjects, each exactly once, in the order that
+  // 'CompoundType::getSubobjects' yields them.  The first element is
+  // the class's own 'subobj'.
+  std::vector<BaseClassSubobj const *> m_subobjects;
+
+  // Map from element of 'm_subobjects' to its index there.
+  std::unordered_map<BaseClassSubobj const *, int> m_subobjectIndex;
+
+  // For each element of 'm_subobjects', the set of indices of
+  // subobjects reachable from it via 'parents' links, including
+  // itself.  This is the "is ancestor of" relation used to decide
+  // whether one member hides another during lookup.
+  std::vector<std::vector<bool> > m_ancestors;
+
+  // Map from class to the number of subobjects of that class.  This
+  // does not include anonymous compound members.
+  std::unordered_map<CompoundType const *, int> m_subobjectCounts;
+
+  // Map from class to its virtual base subobject, for every class
+  // that is inherited virtually.
+  std::unordered_map<CompoundType const *, BaseClassSubobj const *>
+    m_virtualBases;
+
+public:      // class data
+  // Number of indices built.
+  static unsigned long s_numBuilt;
+
+public:      // methods
+  explicit ClassHierarchyIndex(CompoundType const *ct);
+
+  // Number of subobjects of 'ct', ignoring anonymous members.
+  int subobjectCount(CompoundType const *ct) const;
+
+  // True if 'ancestor' is reachable from 'child' via 'parents', where
+  // both are among 'm_subobjects'.
+  bool hasAncestor(BaseClassSubobj const *child,
+                   BaseClassSubobj const *ancestor) const;
+};
+
+
+// Categories of the types yielded by conversion operators, as a
+// bitmask so a query can ask for several at once.
+enum ConversionOperatorKind {
+  COK_NONE       = 0x00,
+  COK_ARITHMETIC = 0x01,     // arithmetic or enumeration type
+  COK_POINTER    = 0x02,     // pointer, pointer-to-member, or array/function (which decay)
+  COK_CLASS      = 0x04,     // class type
+  COK_TEMPLATE   = 0x08,     // contains template parameters
+  COK_OTHER      = 0x10,     // none of the above
+  COK_REFERENCE  = 0x20,     // returns a reference; combined with one of the above
+
+  // what can be tested in a boolean context
+  COK_BOOL_TESTABLE = COK_ARITHMETIC | COK_POINTER,
+
+  COK_ALL        = 0x3F
+};
+ENUM_BITWISE_OPS(ConversionOperatorKind, COK_ALL);
+
+// Classify the return type of a conversion operator.
+ConversionOperatorKind classifyConversionType(Type const *retType);
+
+// one element of 'CompoundType::getConversionOperatorIndex'
+class ConversionOperatorEntry {
+public:      // data
+  Variable *m_var;                      // (serf) the conversion operator
+  ConversionOperatorKind m_kind;        // classification of its return type
+
+public:      // funcs
+  ConversionOperatorEntry(Variable *v, ConversionOperatorKind k)
+    : m_var(v),
+      m_kind(k)
+  {}
+};
+
+
 // A CompoundType represents a class, struct, or union type.  The
 // members of the compound are whatever has been entered in the Scope.
 //
@@ -251,7 +388,8 @@ public:
 // specifically use the "class" keyword, although I now question that
 // decision.
 //
-class CompoundType : public NamedAtomicType, public Scope {
+class CompoundType : public NamedAtomicType, public Scope,
+                     private LiveCount<CompoundType> {
 public:      // types
   // NOTE: keep these consistent with TypeIntr (in file cc-flags.h)
   enum Keyword { K_STRUCT, K_CLASS, K_UNION, NUM_KEYWORDS };
@@ -340,7 +478,29 @@ public:      // data
   // itself while the latter is a PseudoInstantiation thereof
   Type *selfType;                     // (nullable serf)
 
+private:     // data
+  // Most recently computed layout, or NULL.  See 'getLayout'.
+  mutable ClassLayout *m_layout;      // (nullable owner)
+
+  // Index of the subobject hierarchy, or NULL if it has not been
+  // computed since the last change.  See 'getHierarchyIndex'.
+  mutable ClassHierarchyIndex *m_hierarchyIndex;   // (nullable owner)
+
+  // True if some element of 'dataMembers' is an anonymous compound,
+  // which 'countBaseClassSubobjects' has to look inside.
+  bool m_hasAnonymousCompoundMembers;
+
+  // True once 'finishedClassDefinition' has run, so that
+  // 'conversionOperators' is final.
+  bool m_hasFinishedDefinition;
+
+  // 'conversionOperators', in the same order, with the category of
+  // each; built by 'finishedClassDefinition'.
+  std::vector<ConversionOperatorEntry> m_conversionOperatorIndex;
+
 private:     // funcs
+  void computeLayout(ClassLayout &layout) const;
+
   void makeSubobjHierarchy(BaseClassSubobj *subobj, BaseClass const *newBase);
 
   BaseClassSubobj const *findVirtualSubobjectC(CompoundType const *ct) const;
@@ -349,10 +509,8 @@ private:     // funcs
 
   static void clearVisited_helper(BaseClassSubobj const *subobj);
 
-  static void getSubobjects_helper
-    (SObjList<BaseClassSubobj const> &dest, BaseClassSubobj const *subobj);
-
   void addLocalConversionOp(Variable *op);
+  void finishedClassDefinition_conversions(StringRef specialName);
 
 protected:   // funcs
   // create an incomplete (forward-declared) compound
@@ -367,6 +525,10 @@ public:      // funcs
   virtual ~CompoundType();
 
   bool isComplete() const { return !m_isForwardDeclared; }
+  bool hasFinishedDefinition() const { return m_hasFinishedDefinition; }
+
+  // add 'v' to 'friends'
+  void addFriend(Variable *v);
   bool isUnion() const { return keyword == K_UNION; }
 
   // true if this is a class that is incomplete because it requires
@@ -453,13 +615,28 @@ public:      // funcs
   int getDataMemberOffset(
     TypeSizes const &typeSizes, Variable const *dataMember) const;
 
+  // Get the layout of this class under 'typeSizes'.  This is computed
+  // once and then reused until a member or base is added.  May throw
+  // XReprSize.
+  ClassLayout const &getLayout(TypeSizes const &typeSizes) const;
+
+  // Discard the cached layout; called when the class changes.
+  void invalidateLayout();
+
+  // True if the most recently computed layout is final.
+  bool hasStableLayout() const
+    { return isComplete() && m_layout && m_layout->m_stable; }
+
   // add to 'bases'; incrementally maintains 'virtualBases'
   virtual void addBaseClass(BaseClass * /*owner*/ newBase);
 
   // true if this class inherits from 'ct', either directly or
   // indirectly, and the inheritance is virtual
-  bool hasVirtualBase(CompoundType const *ct) const
-    { return !!findVirtualSubobjectC(ct); }
+  bool hasVirtualBase(CompoundType const *ct) const;
+
+  // Get the index of the subobject hierarchy, computing it if
+  // necessary.  It is discarded when a base class is added.
+  ClassHierarchyIndex const &getHierarchyIndex() const;
 
   // set all the 'visited' fields to false in the subobject hierarchy
   void clearSubobjVisited() const;
@@ -470,6 +647,16 @@ public:      // funcs
   // an uninstantiated class won't have any subobjects yet
   void getSubobjects(SObjList<BaseClassSubobj const> &dest) const;
 
+  // Same, but as a reference to the cached array.
+  std::vector<BaseClassSubobj const *> const &getSubobjectsArray() const
+    { return getHierarchyIndex().m_subobjects; }
+
+  // True if 'ancestor' is 'child' or one of its (transitive) parents.
+  // Both must be subobjects of this class.
+  bool subobjectHasAncestor(BaseClassSubobj const *child,
+                            BaseClassSubobj const *ancestor) const
+    { return getHierarchyIndex().hasAncestor(child, ancestor); }
+
   // render the subobject hierarchy to a 'dot' graph
   string renderSubobjHierarchy() const;
 
@@ -493,6 +680,12 @@ public:      // funcs
   // return NULL if no LUB ("least" means most-derived)
   static CompoundType *lub(CompoundType *t1, CompoundType *t2, bool &wasAmbig);
 
+  // Append to 'dest' those elements of 'conversionOperators' whose
+  // return type category is in 'kinds', preserving their order.
+  // Before the class is finished, this yields all of them.
+  void getConversionOperators(ArrayStack<Variable*> &dest,
+                              ConversionOperatorKind kinds) const;
+
   // call this when we're finished adding base classes and member
   // fields; it builds 'conversionOperators'; 'specialName' is the
   // name under which the conversion operators have been filed in
@@ -512,7 +705,7 @@ string toString(CompoundType::Keyword k);
 
 
 // represent an enumerated type
-class EnumType : public NamedAtomicType {
+class EnumType : public NamedAtomicType, private LiveCount<EnumType> {
 public:     // types
   // represent a single value in an enum
   class Value {
@@ -808,7 +1001,9 @@ public:     // funcs
   // are *not* bound in 'map'
   bool containsVariables(MType *map = NULL) const;
 
-  ALLOC_STATS_DECLARE
+  #if ELSA_OBJECT_COUNTS
+    ALLOC_STATS_DECLARE
+  #endif
 };
 
 string cvToString(CVFlags cv);
@@ -842,7 +1037,7 @@ string toString(Type const *t);
 
 // essentially just a wrapper around an atomic type, but
 // also with optional const/volatile flags
-class CVAtomicType : public Type {
+class CVAtomicType : public Type, private LiveCount<CVAtomicType> {
 public:     // data
   AtomicType *atomic;          // (serf) underlying type
   CVFlags cv;                  // const/volatile
@@ -873,7 +1068,7 @@ public:
 
 
 // type of a pointer
-class PointerType : public Type {
+class PointerType : public Type, private LiveCount<PointerType> {
 public:     // data
   CVFlags cv;                  // const/volatile; refers to pointer *itself*
   Type *atType;                // (serf) type of thing pointed-at
@@ -900,7 +1095,7 @@ public:
 
 
 // type of a reference
-class ReferenceType : public Type {
+class ReferenceType : public Type, private LiveCount<ReferenceType> {
 public:     // data
   Type *atType;                // (serf) type of thing pointed-at
 
@@ -943,7 +1138,7 @@ ENUM_BITWISE_OPS(FunctionFlags, FF_ALL);
 
 
 // type of a function
-class FunctionType : public Type {
+class FunctionType : public Type, private LiveCount<FunctionType> {
 public:     // types
   // list of exception types that can be thrown
   class ExnSpec {
@@ -1051,7 +1246,7 @@ public:
 
 
 // type of an array
-class ArrayType : public Type {
+class ArrayType : public Type, private LiveCount<ArrayType> {
 public:       // types
   enum {
     NO_SIZE = -1,              // no size specified
@@ -1091,7 +1286,8 @@ public:
 
 
 // pointer to member
-class PointerToMemberType : public Type {
+class PointerToMemberType : public Type,
+                            private LiveCount<PointerToMemberType> {
 public:
   // Usually, this is a compound type, as ptr-to-members are
   // w.r.t. some compound.  However, to support the 'compound'
@@ -1138,7 +1334,7 @@ public:
 // The rationale for this design is I do not want to force clients to
 // have to "skip typedefs" everywhere since that is error-prone.
 //
-class TypedefType : public Type {
+class TypedefType : public Type, private LiveCount<TypedefType> {
 public:      // class data
   // When true (the default), 'toCString()' prints the name of the
   // typedef in comments.
@@ -1266,8 +1462,19 @@ MAKE_LEGACY_TYPE_NC(PointerToMemberType)
 
 // first, we have the abstract interface of a TypeFactory
 class TypeFactory {
+  NO_OBJECT_COPIES(TypeFactory);
+
+private:   // data
+  // Interned template argument lists, which refer to the types made
+  // by this factory and so live exactly as long as it does.
+  TemplateArgumentListTable *m_templateArgumentLists;    // (owner)
+
 public:
-  virtual ~TypeFactory() {}      // silence stupid compiler warnings
+  TypeFactory();
+  virtual ~TypeFactory();
+
+  TemplateArgumentListTable &templateArgumentLists()
+    { return *m_templateArgumentLists; }
 
   // ---- constructors for the named atomic types ----
   virtual CompoundType *makeCompoundType
@@ -1432,7 +1639,33 @@ private:   // data
   // to be treated as read-only
   static CVAtomicType unqualifiedSimple[NUM_SIMPLE_TYPES];
 
+  // When true, constructed types are allocated from the pools below
+  // rather than individually with 'new'.  Initially false.
+  bool m_compact;
+
+  // Per-factory (hence per-TU) typed pools for compact mode.  Types
+  // still refer to each other by pointer; the pools only save the
+  // per-allocation malloc overhead and keep related types together.
+  TypedPool<CVAtomicType> m_cvAtomicPool;
+  TypedPool<PointerType> m_pointerPool;
+  TypedPool<ReferenceType> m_referencePool;
+  TypedPool<FunctionType> m_functionPool;
+  TypedPool<ArrayType> m_arrayPool;
+  TypedPool<PointerToMemberType> m_ptmPool;
+
 public:    // funcs
+  BasicTypeFactory();
+  ~BasicTypeFactory();
+
+  // Enable or disable compact mode.  Types made while it is enabled
+  // are owned by the factory and must not be deleted individually.
+  void setCompactMode(bool b) { m_compact = b; }
+  bool isCompactMode() const { return m_compact; }
+
+  // Print pool occupancy for compact mode, and an estimate of what
+  // the same types would have cost without it.
+  void printStats(ostream &os) const;
+
   // TypeFactory funcs
   CVAtomicType *makeCVAtomicType(AtomicType *atomic, CVFlags cv) override;
   PointerType *makePointerType(CVFlags cv, Type *atType) override;
@@ -0,0 +1,143 @@
+// concurrent-strtable.cc
+// code for concurrent-strtable.h
+
+#include "concurrent-strtable.h"       // this module
+
+// elsa
+#include "cc-flags.h"                  // operatorFunctionNames
+#include "cc-tokens.h"                 // tokenNameTable, tokenFlagTable
+
+// libc
+#include <string.h>                    // memcpy, strlen
+
+
+// ------------------------------ Shard --------------------------------
+ConcurrentStringTable::Shard::Shard()
+  : m_mutex(),
+    m_strings(),
+    m_blocks(),
+    m_lastBlockUsed(BLOCK_SIZE)        // forces a block on first use
+{}
+
+
+ConcurrentStringTable::Shard::~Shard()
+{
+  for (char *b : m_blocks) {
+    delete[] b;
+  }
+}
+
+
+char const *ConcurrentStringTable::Shard::store(std::string_view str)
+{
+  size_t need = str.size() + 1;
+
+  char *dest;
+  if (need > BLOCK_SIZE/4) {
+    // big string: its own block, inserted before the current one so
+    // the current block can keep filling
+    dest = new char[need];
+    m_blocks.insert(m_blocks.end() - (m_blocks.empty()? 0 : 1), dest);
+  }
+  else {
+    if (m_lastBlockUsed + need > BLOCK_SIZE) {
+      m_blocks.push_back(new char[BLOCK_SIZE]);
+      m_lastBlockUsed = 0;
+    }
+    dest = m_blocks.back() + m_lastBlockUsed;
+    m_lastBlockUsed += need;
+  }
+
+  memcpy(dest, str.data(), str.size());
+  dest[str.size()] = 0;
+  return dest;
+}
+
+
+// ----------------------- ConcurrentStringTable -----------------------
+ConcurrentStringTable::ConcurrentStringTable()
+{
+  // keywords: single-spelling nonseparator tokens
+  for (int i=0; i < tokenNameTableSize; i++) {
+    if ((tokenFlagTable[i] & (TF_MULTISPELL | TF_NONSEPARATOR)) ==
+          TF_NONSEPARATOR) {
+      add(tokenNameTable[i]);
+    }
+  }
+
+  // the names Env::setupOperatorOverloading looks up
+  for (int i=0; i < NUM_OVERLOADABLE_OPS; i++) {
+    add(operatorFunctionNames[i]);
+  }
+}
+
+
+ConcurrentStringTable::~ConcurrentStringTable()
+{}
+
+
+ConcurrentStringTable::Shard &
+  ConcurrentStringTable::shardFor(std::string_view str)
+{
+  size_t h = std::hash<std::string_view>()(str);
+
+  // mix the high bits down, since some hashes vary mostly there
+  return m_shards[(h ^ (h >> 17)) & (NUM_SHARDS-1)];
+}
+
+
+ConcurrentStringTable::Shard const &
+  ConcurrentStringTable::shardFor(std::string_view str) const
+{
+  return const_cast<ConcurrentStringTable*>(this)->shardFor(str);
+}
+
+
+StringRef ConcurrentStringTable::add(char const *src)
+{
+  return add(src, strlen(src));
+}
+
+
+StringRef ConcurrentStringTable::add(char const *src, size_t len)
+{
+  std::string_view str(src, len);
+  Shard &shard = shardFor(str);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto it = shard.m_strings.find(str);
+  if (it != shard.m_strings.end()) {
+    return it->data();
+  }
+
+  char const *stored = shard.store(str);
+  shard.m_strings.insert(std::string_view(stored, len));
+  return stored;
+}
+
+
+StringRef ConcurrentStringTable::get(char const *src) const
+{
+  std::string_view str(src);
+  Shard const &shard = shardFor(str);
+
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+  auto it = shard.m_strings.find(str);
+  return it == shard.m_strings.end()? NULL : it->data();
+}
+
+
+size_t ConcurrentStringTable::count() const
+{
+  size_t ret = 0;
+  for (Shard const &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    ret += shard.m_strings.size();
+  }
+  return ret;
+}
+
+
+// EOF
@@ -0,0 +1,95 @@
+// concurrent-strtable.h
+// ConcurrentStringTable, a thread-safe string interning table.
+
+#ifndef ELSA_CONCURRENT_STRTABLE_H
+#define ELSA_CONCURRENT_STRTABLE_H
+
+// smbase
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
+#include "strtable.h"                  // StringRef
+
+// libc++
+#include <mutex>                       // std::mutex
+#include <string_view>                 // std::string_view
+#include <unordered_set>               // std::unordered_set
+#include <vector>                      // std::vector
+
+// libc
+#include <stddef.h>                    // size_t
+
+
+// Interns strings like smbase's StringTable, and can be shared by
+// threads that parse or analyze different translation units at the
+// same time.  Interned strings are StringRefs: NUL-terminated, never
+// moved or freed before the table is, and equal as pointers exactly
+// when equal as strings, so StringRef comparisons work across all
+// threads that use the same table.
+//
+// The table is split into shards by hash, each with its own lock and
+// its own storage, so threads interning different strings rarely
+// contend.
+//
+// 'add' and 'get' have the same signatures as their StringTable
+// counterparts, so code templatized on the table type can use either.
+class ConcurrentStringTable {
+  NO_OBJECT_COPIES(ConcurrentStringTable);
+
+private:     // types
+  enum {
+    // Number of shards; a power of 2.
+    NUM_SHARDS = 64,
+
+    // Size of each storage block.  Strings longer than a quarter
+    // of this get a block of their own.
+    BLOCK_SIZE = 16384,
+  };
+
+  struct Shard {
+    // Protects the other members.
+    mutable std::mutex m_mutex;
+
+    // Interned strings, viewing into 'm_blocks'.
+    std::unordered_set<std::string_view> m_strings;
+
+    // Storage blocks (owner).
+    std::vector<char*> m_blocks;
+
+    // Bytes used in the last block of 'm_blocks'.
+    size_t m_lastBlockUsed;
+
+    Shard();
+    ~Shard();
+
+    // Copy 'str' (plus a NUL) into storage; 'm_mutex' must be held.
+    char const *store(std::string_view str);
+  };
+
+private:     // data
+  Shard m_shards[NUM_SHARDS];
+
+private:     // funcs
+  Shard &shardFor(std::string_view str);
+  Shard const &shardFor(std::string_view str) const;
+
+public:      // funcs
+  // Make a table that already contains the C/C++ keywords and the
+  // 'operatorFunctionNames[]' spellings, so threads do not all race
+  // to intern them when they set up their Envs.
+  ConcurrentStringTable();
+  ~ConcurrentStringTable();
+
+  // Return the canonical StringRef for 'src', adding it if needed.
+  StringRef add(char const *src);
+  StringRef add(char const *src, size_t len);
+
+  // Return the canonical StringRef for 'src' if it has been added,
+  // or NULL if not.
+  StringRef get(char const *src) const;
+
+  // Number of distinct strings interned.  This takes every shard lock
+  // in turn, so it is only a snapshot if other threads are adding.
+  size_t count() const;
+};
+
+
+#endif // ELSA_CONCURRENT_STRTABLE_H
@@ -0,0 +1,146 @@
+// concurrent-strtable_test.cc
+// test program for ConcurrentStringTable.
+
+#include "concurrent-strtable.h"       // module under test
+
+// smbase
+#include "exc.h"                       // xassert
+#include "sm-iostream.h"               // cout
+#include "str.h"                       // stringb
+
+// libc++
+#include <string>                      // std::string
+#include <thread>                      // std::thread
+#include <vector>                      // std::vector
+
+// libc
+#include <string.h>                    // strcmp
+
+
+// Keywords and operator names are there from the start, and 'get'
+// neither adds nor finds anything else.
+static void testPreinterned()
+{
+  ConcurrentStringTable table;
+
+  size_t initial = table.count();
+  xassert(initial > 0);
+
+  StringRef kw = table.get("while");
+  xassert(kw && 0==strcmp(kw, "while"));
+  xassert(table.add("while") == kw);
+  xassert(table.get("operator+"));
+
+  xassert(table.get("not_a_keyword") == NULL);
+  xassert(table.count() == initial);
+}
+
+
+// Basic interning: equal strings give equal pointers, different
+// strings give different ones, and the length form matches.
+static void testAdd()
+{
+  ConcurrentStringTable table;
+  size_t initial = table.count();
+
+  StringRef a = table.add("alpha");
+  xassert(0==strcmp(a, "alpha"));
+  xassert(table.add("alpha") == a);
+  xassert(table.get("alpha") == a);
+
+  StringRef b = table.add("alphabet", 5);
+  xassert(b == a);
+
+  StringRef c = table.add("alphabet");
+  xassert(c != a && 0==strcmp(c, "alphabet"));
+
+  StringRef empty = table.add("");
+  xassert(empty && *empty == 0);
+  xassert(table.add("x", 0) == empty);
+
+  xassert(table.count() == initial + 3);
+}
+
+
+// Strings too big for a shared block go in blocks of their own; the
+// shared block must keep filling without clobbering or being
+// clobbered by them.
+static void testBigStrings()
+{
+  ConcurrentStringTable table;
+
+  std::vector<std::string> strs;
+  std::vector<StringRef> refs;
+  for (int i=0; i < 2000; i++) {
+    std::string s = (i % 10 == 3)?
+      std::string(5000 + i, (char)('a' + i%26)) :    // > BLOCK_SIZE/4
+      std::string(stringb("small" << i).c_str());
+    strs.push_back(s);
+    refs.push_back(table.add(s.c_str()));
+  }
+
+  for (size_t i=0; i < strs.size(); i++) {
+    xassert(0==strcmp(refs[i], strs[i].c_str()));
+    xassert(table.add(strs[i].c_str()) == refs[i]);
+  }
+}
+
+
+// Interning the same strings from several threads at once, in
+// different orders, must give every thread the same pointers.
+static void testThreads()
+{
+  enum { NUM_THREADS = 8, NUM_STRINGS = 5000 };
+
+  ConcurrentStringTable table;
+  size_t initial = table.count();
+
+  std::vector<std::string> strs;
+  for (int i=0; i < NUM_STRINGS; i++) {
+    strs.push_back(std::string(stringb("s" << i).c_str()));
+  }
+
+  std::vector<std::vector<StringRef> > results(NUM_THREADS,
+    std::vector<StringRef>(NUM_STRINGS));
+
+  std::vector<std::thread> threads;
+  for (int t=0; t < NUM_THREADS; t++) {
+    threads.push_back(std::thread([&table, &strs, &results, t]() {
+      for (int n=0; n < NUM_STRINGS; n++) {
+        // odd threads go backwards, and each starts somewhere else
+        int i = (t*613 + (t%2? NUM_STRINGS-1-n : n)) % NUM_STRINGS;
+        results[t][i] = table.add(strs[i].c_str());
+      }
+    }));
+  }
+  for (std::thread &th : threads) {
+    th.join();
+  }
+
+  for (int i=0; i < NUM_STRINGS; i++) {
+    StringRef r = results[0][i];
+    xassert(0==strcmp(r, strs[i].c_str()));
+    for (int t=1; t < NUM_THREADS; t++) {
+      xassert(results[t][i] == r);
+    }
+    xassert(table.get(strs[i].c_str()) == r);
+  }
+
+  xassert(table.count() == initial + NUM_STRINGS);
+}
+
+
+int main()
+{
+  testPreinterned();
+  testAdd();
+  testBigStrings();
+  testThreads();
+
+  cout << "concurrent-strtable_test: PASS.\n"
+       << flush;
+  return 0;
+}
+
+
+// EOF
@@ -12,6 +12,8 @@
 #include "cc-lang.h"                   // CCLang
 #include "cc-print.h"                  // PrintEnv
 #include "integrity.h"                 // IntegrityVisitor
+#include "mem-stats.h"                 // printMemStats, printSizeReport
+#include "overload.h"                  // OverloadStats
 #include "parssppt.h"                  // ParseTreeAndTokens, treeMain
 #include "sprint.h"                    // structurePrint
 
@@ -233,6 +235,16 @@ bool ElsaParse::parse(char const *inputFname)
   ArrayStack<Variable*> madeUpVariables;
   ArrayStack<Variable*> builtinVars;
 
+  // allocate types from per-TU pools
+  if (tracingSys("compactTypes")) {
+    m_typeFactory.setCompactMode(true);
+  }
+
+  // sizes of the numerous classes in this build configuration
+  if (tracingSys("sizeReport")) {
+    printSizeReport(cout);
+  }
+
   int parseWarnings = 0;
   {
     SectionTimer timer(m_parseTime);
@@ -301,6 +313,8 @@ bool ElsaParse::parse(char const *inputFname)
   //  cout << "ambiguous nodes: " << numAmbiguousNodes(m_translationUnit) << endl;
   //}
 
+  maybePrintMemStats("parse");
+
   if (tracingSys("stopAfterParse")) {
     return true;
   }
@@ -404,6 +418,17 @@ bool ElsaParse::parse(char const *inputFname)
       traceProgress() << "end of second tcheck\n";
     }
 
+    // statistics for the various tcheck caches
+    if (tracingSys("cacheStats")) {
+      env.printCacheStats(cout);
+      m_typeFactory.printStats(cout);
+    }
+
+    // where overload resolution spent its time
+    if (env.overloadStats()) {
+      env.overloadStats()->print(cout, 10 /*topN*/);
+    }
+
     // print errors and warnings
     env.errors.print(cerr, m_printWarnings);
 
@@ -445,11 +470,13 @@ bool ElsaParse::parse(char const *inputFname)
       Variable *mainVar =
         env.globalScope()->lookupVariable(mainName, env);
       if (mainVar) {
-        m_mainFunction = mainVar->funcDefn;
+        m_mainFunction = mainVar->getFuncDefn();
       }
     }
   }
 
+  maybePrintMemStats("tcheck");
+
   // ---------------- integrity checking ----------------
   {
     SectionTimer timer(m_integrityTime);
@@ -480,6 +507,8 @@ bool ElsaParse::parse(char const *inputFname)
     }
   }
 
+  maybePrintMemStats("integrity");
+
   // ----------------- elaboration ------------------
   if (tracingSys("no-elaborate")) {
     cerr << "no-elaborate" << endl;
@@ -517,6 +546,8 @@ bool ElsaParse::parse(char const *inputFname)
     }
   }
 
+  maybePrintMemStats("elaboration");
+
   // mark "real" (non-template) variables as such
   {
     MarkRealVars markReal;
@@ -618,6 +649,16 @@ void ElsaParse::maybePrettyPrint()
 }
 
 
+void ElsaParse::maybePrintMemStats(char const *phase)
+{
+  if (tracingSys("memstats")) {
+    // The lowered walk, which includes instantiations, needs a
+    // completely type-checked AST.
+    printMemStats(cout, phase, m_translationUnit, m_tcheckCompleted);
+  }
+}
+
+
 void ElsaParse::printTimes()
 {
   cerr << "parse=" << m_parseTime << "ms"
@@ -127,6 +127,9 @@ public:      // methods
   // If 'm_prettyPrint', pretty-print the AST.
   void maybePrettyPrint();
 
+  // If "-tr memstats", print the memory report for the end of 'phase'.
+  void maybePrintMemStats(char const *phase);
+
   // Print the phase times.
   void printTimes();
 
@@ -15,6 +15,7 @@ cc.gr.gen.o: cc.ast.gen.h
 ccparse.o: cc.ast.gen.h
 cfg.o: cc.ast.gen.h
 clang-import.o: cc.ast.gen.h
+concurrent-strtable.o: cc-tokens.h
 const-eval.o: cc.ast.gen.h
 elsaparse.o: cc-tokens.h
 elsaparse.o: cc.ast.gen.h
@@ -31,6 +32,7 @@ lexer.o: lexer.yy.h
 lexer.yy.o: cc-tokens.h
 main.o: cc.ast.gen.h
 mangle.o: cc.ast.gen.h
+mem-stats.o: cc.ast.gen.h
 mtype.o: cc.ast.gen.h
 overload.o: cc.ast.gen.h
 parssppt.o: cc-tokens.h
@@ -6,6 +6,7 @@
 #include "variable.h"      // Variable
 #include "overload.h"      // resolveOverload
 #include "trace.h"         // tracingSys
+#include "line-table.h"    // getSourceLocLine
 
 
 // prototypes
@@ -374,7 +375,7 @@ StandardConversion tryCallCtor
 // ----------------- test_getImplicitConversion ----------------
 int getLine(SourceLoc loc)
 {
-  return sourceLocManager->getLine(loc);
+  return getSourceLocLine(loc);
 }
 
 
@@ -0,0 +1,75 @@
+// t0590.cc
+// redeclarations and definitions in an overload set large enough to
+// be indexed by signature; be careful with line numbers!
+
+struct A {};
+struct B {};
+enum E { e0 };
+typedef int Int;
+typedef A const &ACRef;
+
+// declarations; some pairs differ only in cv-qualification below the
+// top level, so they share a signature hash
+int f(int);
+int f(char);
+int f(long);
+int f(B);
+int f(A *);
+int f(A const *);
+int f(A &);
+int f(A const &);
+int f(E);
+int f(int, int);
+int f(int, A *);
+template <class T> int f(T *, T *);
+template <class T> int f(T, int, int);
+
+// each definition must find its declaration, not start a new overload
+int f(int const i) { return 1; }               // line 28
+int f(char) { return 2; }                      // line 29
+int f(long) { return 3; }                      // line 30
+int f(B) { return 4; }                         // line 31
+int f(A const *p) { return 5; }                // line 32
+int f(A *p) { return 6; }                      // line 33
+int f(ACRef a) { return 7; }                   // line 34
+int f(A &a) { return 8; }                      // line 35
+int f(E) { return 9; }                         // line 36
+int f(Int, Int) { return 10; }                 // line 37
+int f(int, A *const) { return 11; }            // line 38
+template <class T> int f(T *, T *) { return 12; }      // line 39
+template <class T> int f(T, int, int) { return 13; }   // line 40
+
+// a second definition is found, too
+//ERROR(1): int f(char) { return 0; }
+
+// including among the members the index cannot hash
+//ERROR(2): template <class T> int f(T *, T *) { return 0; }
+
+void g()
+{
+  __testOverload(g(), 48);     // turn on overload resolution
+
+  A a;
+  A const &ca = a;
+  B b;
+  E e = e0;
+  int i = 0;
+  char c = 0;
+  long l = 0;
+
+  __checkCalleeDefnLine(f(i), 28);
+  __checkCalleeDefnLine(f(c), 29);
+  __checkCalleeDefnLine(f(l), 30);
+  __checkCalleeDefnLine(f(b), 31);
+  __checkCalleeDefnLine(f(&ca), 32);
+  __checkCalleeDefnLine(f(&a), 33);
+  __checkCalleeDefnLine(f(ca), 34);
+  __checkCalleeDefnLine(f(a), 35);
+  __checkCalleeDefnLine(f(e), 36);
+  __checkCalleeDefnLine(f(i, i), 37);
+  __checkCalleeDefnLine(f(i, &a), 38);
+  __checkCalleeDefnLine(f(&a, &a), 39);
+  __checkCalleeDefnLine(f(c, i, i), 40);
+}
+
+// EOF
@@ -0,0 +1,50 @@
+// t0591.cc
+// member declarations that replace using-declarations (7.3.3 para 12)
+// in an overload set large enough to be indexed by signature; be
+// careful with line numbers!
+
+struct A {};
+struct B {};
+
+struct Base {
+  int f(int);
+  int f(char);
+  int f(long);
+  int f(A);
+  int f(B);
+  int f(A *);
+  int f(B *);
+  int f(int, int);
+  int f(int, char);
+  int f(int, A *);
+};
+
+struct Derived : Base {
+  using Base::f;        // aliases for all of the above
+
+  int f(int);           // replaces the alias
+  int f(A *);           // likewise
+  int f(double);        // a new overload
+
+  // the replacements are now ordinary members, so declaring them
+  // again is an error
+  //ERROR(1): int f(int);
+  //ERROR(2): int f(A * const);
+};
+
+// the definitions must find the replaced members
+int Derived::f(int) { return 1; }              // line 36
+int Derived::f(A *) { return 2; }              // line 37
+int Derived::f(double) { return 3; }           // line 38
+
+void g(Derived &d)
+{
+  __testOverload(g(d), 40);     // turn on overload resolution
+
+  A a;
+  __checkCalleeDefnLine(d.f(1), 36);
+  __checkCalleeDefnLine(d.f(&a), 37);
+  __checkCalleeDefnLine(d.f(1.0), 38);
+}
+
+// EOF
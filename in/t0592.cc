@@ -0,0 +1,55 @@
+// t0592.cc
+// qualified lookups repeated after the qualifying namespaces gain
+// members, which invalidates remembered qualifier lookups
+
+namespace N {
+  struct X {
+    typedef int T;
+  };
+
+  namespace M {
+    typedef char T;
+  }
+}
+
+N::X::T a1;
+N::M::T b1;
+
+// reopen 'N', adding members to it and to 'N::M'
+namespace N {
+  int y;
+  struct Z {
+    typedef long T;
+  };
+
+  namespace M {
+    typedef short U;
+  }
+}
+
+N::X::T a2;
+N::M::T b2;
+N::M::U c2;
+N::Z::T d2;
+
+//ERROR(1): N::M::V e2;
+//ERROR(2): N::Y::T f2;
+
+void f()
+{
+  int i;
+  char c;
+  short s;
+  long l;
+
+  __elsa_checkType(a1, i);
+  __elsa_checkType(a2, i);
+  __elsa_checkType(b1, c);
+  __elsa_checkType(b2, c);
+  __elsa_checkType(c2, s);
+  __elsa_checkType(d2, l);
+
+  //ERROR(3): __elsa_checkType(b2, i);
+}
+
+// EOF
@@ -0,0 +1,75 @@
+// t0593.cc
+// the same dependent qualified type in out-of-line definitions in
+// different class scopes, where it can be resolved only in some
+
+template <class T>
+struct A {};
+
+template <class V>
+struct B {
+  typedef int I;
+  A<I> f();
+
+  struct Inner {
+    typedef char I;
+    int h();
+  };
+  A<I> g();
+};
+
+template <class V>
+struct C {
+  typedef float I;
+  A<I> f();
+  A<typename B<V>::I> k();
+};
+
+// 'B<V>' is in scope, so 'B<V>::I' is 'int'
+template <class V>
+A<typename B<V>::I> B<V>::f()
+{}
+
+// 'B<V>' is not in scope, so 'B<V>::I' stays dependent
+template <class V>
+A<typename B<V>::I> C<V>::k()
+{}
+
+// 'C<V>::I' is 'float'
+template <class V>
+A<typename C<V>::I> C<V>::f()
+{}
+
+// inside 'B<V>::Inner', 'I' would be 'char'
+template <class V>
+int B<V>::Inner::h()
+{
+  I i = 'c';
+  return sizeof(i);
+}
+
+// back in 'B<V>' alone
+template <class V>
+A<typename B<V>::I> B<V>::g()
+{}
+
+void use()
+{
+  A<int> ai;
+  A<float> af;
+
+  B<int> b;
+  ai = b.f();
+  ai = b.g();
+
+  C<int> c;
+  af = c.f();
+  ai = c.k();
+
+  //ERROR(1): af = c.k();
+  //ERROR(2): ai = c.f();
+
+  B<int>::Inner in;
+  in.h();
+}
+
+// EOF
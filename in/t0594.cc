@@ -0,0 +1,60 @@
+// t0594.cc
+// default arguments of function templates, and of member templates
+// of class template instantiations, used by several instantiations
+
+// each instantiation must tcheck its own copy of a default argument;
+// if they shared one, the second would see the first's 'T*'
+template <class T>
+int f(T t, T *p = (T*)0, int n = sizeof(T))
+{
+  return n;
+}
+
+template <class T>
+struct S {
+  // the member template of 'S<int>' is itself an instantiation, whose
+  // default arguments are tchecked in place when it is instantiated
+  template <class U>
+  int g(U u, U *p = (U*)0, T *q = (T*)0, int n = sizeof(U) + sizeof(T))
+  {
+    return n;
+  }
+
+  int h(T t, T *p = (T*)0)
+  {
+    return 0;
+  }
+};
+
+void use()
+{
+  // two instantiations of 'f', both using the default arguments
+  f(1);
+  f('c');
+  f(1.0);
+
+  // and again, after they are instantiated
+  f(2);
+  f('d');
+
+  // explicitly passing the argument that would be defaulted
+  double d;
+  f(d, &d);
+
+  S<int> si;
+  si.g('c');
+  si.g(1.0);
+  si.g(1, (int*)0);
+  si.h(1);
+
+  S<char> sc;
+  sc.g(1);
+  sc.g(1.0);
+  sc.h('c');
+
+  //ERROR(1): f(1, (char*)0);
+  //ERROR(2): si.g('c', (int*)0);
+  //ERROR(3): sc.g(1, (int*)0, (int*)0);
+}
+
+// EOF
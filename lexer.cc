@@ -183,6 +183,9 @@ void Lexer::parseHashLine(char const *directive, int len)
   if (*directive == '\n') {
     // no filename: use previous
     srcFile->addHashLine(curLine, lineNum, prevHashLineFile);
+    if (lineTableFile) {
+      lineTableFile->addHashLine(curLine, lineNum, prevHashLineFile);
+    }
     return;
   }
 
@@ -209,6 +212,9 @@ void Lexer::parseHashLine(char const *directive, int len)
 
   // remember this directive
   srcFile->addHashLine(curLine, lineNum, fname);
+  if (lineTableFile) {
+    lineTableFile->addHashLine(curLine, lineNum, fname);
+  }
 
   // remember the filename for future #line directives that
   // don't explicitly include one
@@ -0,0 +1,252 @@
+// line-table.cc
+// code for line-table.h
+
+#include "line-table.h"                // this module
+
+// smbase
+#include "sm-iostream.h"               // ostream
+#include "xassert.h"                   // xassert
+
+// libc++
+#include <algorithm>                   // std::upper_bound, std::sort
+
+// libc
+#include <string.h>                    // memchr
+
+
+// ------------------------- LineTable::File ---------------------------
+LineTable::File::File(char const *name, SourceLoc begin)
+  : m_name(name),
+    m_begin(begin),
+    m_end(0),
+    m_broken(false),
+    m_lineStarts(),
+    m_hashLines()
+{
+  m_lineStarts.push_back(0);
+}
+
+
+void LineTable::File::noteText(SourceLoc loc, char const *text, int len)
+{
+  int offset = (int)loc - (int)m_begin;
+  if (offset != m_end) {
+    m_broken = true;
+  }
+  if (m_broken) {
+    return;
+  }
+
+  char const *p = text;
+  char const *end = text + len;
+  while (p < end) {
+    char const *nl = (char const*)memchr(p, '\n', end - p);
+    if (!nl) {
+      break;
+    }
+    m_lineStarts.push_back(offset + (nl+1 - text));
+    p = nl+1;
+  }
+
+  m_end = offset + len;
+}
+
+
+void LineTable::File::addHashLine(int ppLine, int origLine,
+                                  char const *origFname)
+{
+  xassert(m_hashLines.empty() || m_hashLines.back().m_ppLine <= ppLine);
+  m_hashLines.push_back(HashLine(ppLine, origLine, origFname));
+}
+
+
+void LineTable::File::decodeOffset(int offset, DecodedLoc &out) const
+{
+  // last line start <= offset
+  auto it = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(),
+                             offset);
+  xassert(it != m_lineStarts.begin());
+  --it;
+
+  out.m_fname = m_name.c_str();
+  out.m_line = (it - m_lineStarts.begin()) + 1;
+  out.m_col = offset - *it + 1;
+
+  if (!sourceLocManager->useHashLines || m_hashLines.empty()) {
+    return;
+  }
+
+  // last directive at or before this line
+  auto hl = std::upper_bound(m_hashLines.begin(), m_hashLines.end(),
+    out.m_line,
+    [](int line, HashLine const &h) { return line < h.m_ppLine; });
+  if (hl == m_hashLines.begin()) {
+    return;                  // precedes all directives
+  }
+  --hl;
+
+  // the line after the directive is the line it names
+  out.m_fname = hl->m_origFname;
+  out.m_line = hl->m_origLine + (out.m_line - hl->m_ppLine - 1);
+}
+
+
+// ---------------------------- LineTable ------------------------------
+LineTable::LineTable()
+  : m_files(),
+    m_numDecodes(0),
+    m_numFallbacks(0)
+{}
+
+
+LineTable::~LineTable()
+{
+  for (File *f : m_files) {
+    delete f;
+  }
+}
+
+
+STATICDEF LineTable &LineTable::global()
+{
+  static LineTable *instance = new LineTable;
+  return *instance;
+}
+
+
+LineTable::File *LineTable::beginFile(char const *name, SourceLoc begin)
+{
+  auto it = std::upper_bound(m_files.begin(), m_files.end(), begin,
+    [](SourceLoc loc, File const *f) { return (int)loc < (int)f->m_begin; });
+  if (it != m_files.begin() && (*(it-1))->m_begin == begin) {
+    return NULL;             // already indexed
+  }
+
+  File *f = new File(name, begin);
+  m_files.insert(it, f);
+  return f;
+}
+
+
+LineTable::File const *LineTable::findFile(SourceLoc loc) const
+{
+  auto it = std::upper_bound(m_files.begin(), m_files.end(), loc,
+    [](SourceLoc loc, File const *f) { return (int)loc < (int)f->m_begin; });
+  if (it == m_files.begin()) {
+    return NULL;
+  }
+  File const *f = *(it-1);
+  if (f->m_broken ||
+      (int)loc - (int)f->m_begin > f->m_end) {
+    return NULL;             // past what the lexer saw
+  }
+  return f;
+}
+
+
+bool LineTable::tryDecode(SourceLoc loc, DecodedLoc &out) const
+{
+  m_numDecodes++;
+
+  File const *f = findFile(loc);
+  if (!f) {
+    m_numFallbacks++;
+    return false;
+  }
+  f->decodeOffset((int)loc - (int)f->m_begin, out);
+  return true;
+}
+
+
+DecodedLoc LineTable::decode(SourceLoc loc) const
+{
+  DecodedLoc ret;
+  if (!tryDecode(loc, ret)) {
+    sourceLocManager->decodeLineCol(loc, ret.m_fname, ret.m_line, ret.m_col);
+  }
+  return ret;
+}
+
+
+void LineTable::decodeMany(SourceLoc const *locs, int n,
+                           DecodedLoc *out) const
+{
+  // visit the locations in increasing order so consecutive ones
+  // usually share a file
+  std::vector<int> order(n);
+  for (int i=0; i < n; i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [locs](int a, int b) {
+    return (int)locs[a] < (int)locs[b];
+  });
+
+  File const *f = NULL;
+  for (int i : order) {
+    SourceLoc loc = locs[i];
+    int offset = f? (int)loc - (int)f->m_begin : -1;
+    if (!f || offset < 0 || offset > f->m_end || f->m_broken) {
+      f = findFile(loc);
+      offset = f? (int)loc - (int)f->m_begin : -1;
+    }
+
+    m_numDecodes++;
+    if (f) {
+      f->decodeOffset(offset, out[i]);
+    }
+    else {
+      m_numFallbacks++;
+      sourceLocManager->decodeLineCol(loc, out[i].m_fname,
+                                      out[i].m_line, out[i].m_col);
+    }
+  }
+}
+
+
+void LineTable::printStats(ostream &os) const
+{
+  size_t lines = 0;
+  size_t hashLines = 0;
+  for (File const *f : m_files) {
+    lines += f->m_lineStarts.size();
+    hashLines += f->m_hashLines.size();
+  }
+
+  os << "line table files: " << m_files.size() << "\n"
+     << "line table lines: " << lines << "\n"
+     << "line table #line directives: " << hashLines << "\n"
+     << "line table decodes: " << m_numDecodes << "\n"
+     << "line table fallbacks: " << m_numFallbacks << "\n";
+}
+
+
+// --------------------------- free functions --------------------------
+void decodeSourceLoc(SourceLoc loc, char const *&fname, int &line, int &col)
+{
+  DecodedLoc d = LineTable::global().decode(loc);
+  fname = d.m_fname;
+  line = d.m_line;
+  col = d.m_col;
+}
+
+
+int getSourceLocLine(SourceLoc loc)
+{
+  return LineTable::global().decode(loc).m_line;
+}
+
+
+string sourceLocString(SourceLoc loc)
+{
+  DecodedLoc d;
+  if (LineTable::global().tryDecode(loc, d)) {
+    return stringb(d.m_fname << ":" << d.m_line << ":" << d.m_col);
+  }
+  else {
+    // keep the SourceLocManager spelling of unusual locations
+    return toString(loc);
+  }
+}
+
+
+// EOF
@@ -0,0 +1,144 @@
+// line-table.h
+// LineTable, an indexed SourceLoc decoder fed by the lexer.
+
+#ifndef ELSA_LINE_TABLE_H
+#define ELSA_LINE_TABLE_H
+
+// smbase
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
+#include "srcloc.h"                    // SourceLoc
+#include "str.h"                       // string
+
+// libc++
+#include <vector>                      // std::vector
+
+
+// A decoded source location.
+struct DecodedLoc {
+  char const *m_fname;       // file name, after '#line' remapping
+  int m_line;                // 1-based line, after '#line' remapping
+  int m_col;                 // 1-based column
+
+  DecodedLoc() : m_fname(NULL), m_line(0), m_col(0) {}
+};
+
+
+// Maps SourceLocs in files scanned by the lexer to file, line and
+// column.  As the lexer consumes a file, it records the offset of
+// every line start and every '#line' directive, so decoding is two
+// binary searches (plus one to find the file) regardless of file size
+// or directive count, and never touches the file again.
+//
+// Locations the table does not cover (static locations, files that
+// were not lexed from the start, text past the last token seen) are
+// decoded by 'sourceLocManager' instead.
+class LineTable {
+  NO_OBJECT_COPIES(LineTable);
+
+public:      // types
+  // Index for one lexed file.
+  class File {
+    NO_OBJECT_COPIES(File);
+
+  private:     // types
+    // A '#line' directive.
+    struct HashLine {
+      int m_ppLine;                    // line of the directive itself
+      int m_origLine;                  // line number it names
+      char const *m_origFname;         // file it names
+
+      HashLine(int pp, int orig, char const *fname)
+        : m_ppLine(pp), m_origLine(orig), m_origFname(fname) {}
+    };
+
+  public:      // data
+    // Name of the file as given to the lexer.
+    string m_name;
+
+    // Location of the first character.
+    SourceLoc m_begin;
+
+    // Offset from 'm_begin' one past the last character scanned.
+    int m_end;
+
+    // True if the text was not reported contiguously, so the index
+    // cannot be trusted and is not used.
+    bool m_broken;
+
+    // Offset from 'm_begin' of the start of each line; element i is
+    // line i+1, so element 0 is always 0.  Strictly increasing.
+    std::vector<int> m_lineStarts;
+
+    // '#line' directives in order of appearance, hence sorted by
+    // 'm_ppLine'.
+    std::vector<HashLine> m_hashLines;
+
+  public:      // funcs
+    File(char const *name, SourceLoc begin);
+
+    // Record that 'len' characters of 'text' were scanned starting at
+    // 'loc', which should be where the previous text ended; if not,
+    // the file is marked broken.
+    void noteText(SourceLoc loc, char const *text, int len);
+
+    // Record a '#line' directive on line 'ppLine' naming 'origLine'
+    // of 'origFname'.  'origFname' must outlive the table.
+    void addHashLine(int ppLine, int origLine, char const *origFname);
+
+    // Decode an offset within this file.
+    void decodeOffset(int offset, DecodedLoc &out) const;
+  };
+
+private:     // data
+  // All files, sorted by 'm_begin'.
+  std::vector<File*> m_files;
+
+  // Counters for "-tr cacheStats".
+  mutable unsigned long m_numDecodes;
+  mutable unsigned long m_numFallbacks;
+
+private:     // funcs
+  // File containing 'loc', or NULL.
+  File const *findFile(SourceLoc loc) const;
+
+public:      // funcs
+  LineTable();
+  ~LineTable();
+
+  // The table used by the lexer and by 'decodeSourceLoc'.
+  static LineTable &global();
+
+  // Start indexing the file 'name' whose first character is at
+  // 'begin'.  Returns NULL if that file is already indexed, in which
+  // case the caller should not record anything.
+  File *beginFile(char const *name, SourceLoc begin);
+
+  // Decode 'loc', applying '#line' remapping if
+  // 'sourceLocManager->useHashLines'.  Return false if the table does
+  // not cover 'loc'.
+  bool tryDecode(SourceLoc loc, DecodedLoc &out) const;
+
+  // Like 'tryDecode', but fall back to 'sourceLocManager'.
+  DecodedLoc decode(SourceLoc loc) const;
+
+  // Decode 'n' locations from 'locs' into 'out'.  This sorts the
+  // work by location, so it is cheaper per location than calling
+  // 'decode' in a loop when many locations share a file.
+  void decodeMany(SourceLoc const *locs, int n, DecodedLoc *out) const;
+
+  void printStats(ostream &os) const;
+};
+
+
+// Same interface as 'SourceLocManager::decodeLineCol', but using the
+// global LineTable.
+void decodeSourceLoc(SourceLoc loc, char const *&fname, int &line, int &col);
+
+// Line number of 'loc', as with 'SourceLocManager::getLine'.
+int getSourceLocLine(SourceLoc loc);
+
+// "file:line:col", as with 'toString(SourceLoc)'.
+string sourceLocString(SourceLoc loc);
+
+
+#endif // ELSA_LINE_TABLE_H
@@ -0,0 +1,218 @@
+// line-table_test.cc
+// test program for LineTable.
+
+// Every location in a file is decoded both by a LineTable and by
+// sourceLocManager, which reads the file itself, and the answers must
+// agree, with and without '#line' remapping.
+
+#include "line-table.h"                // module under test
+
+// smbase
+#include "exc.h"                       // xassert
+#include "sm-iostream.h"               // cout
+#include "srcloc.h"                    // SourceLocManager
+
+// libc
+#include <stdio.h>                     // fopen, remove
+#include <string.h>                    // strcmp, strlen
+
+
+// name of the scratch input file
+static char const *fname = "line-table_test.tmp";
+
+// its contents; lines 3 and 7 are '#line' directives
+static char const text[] =
+  "int a;\n"
+  "int b;\n"
+  "# 10 \"foo.h\"\n"
+  "int c;\n"
+  "\n"
+  "  int d;\n"
+  "# 1 \"bar.h\"\n"
+  "int e; int f;\n"
+  "int g;";
+
+
+static SourceLoc locAt(int offset)
+{
+  return sourceLocManager->encodeOffset(fname, offset);
+}
+
+
+// Feed the first 'len' characters of 'text' to 'f' in chunks of
+// varying size, as the lexer would, along with the directives.
+static void feed(LineTable::File *f, int len)
+{
+  int chunk = 1;
+  for (int offset = 0; offset < len; offset += chunk, chunk = chunk%5 + 1) {
+    int n = offset+chunk <= len? chunk : len-offset;
+    f->noteText(locAt(offset), text+offset, n);
+  }
+  f->addHashLine(3, 10, "foo.h");
+  f->addHashLine(7, 1, "bar.h");
+}
+
+
+// Check that 'table' decodes every location in the file as
+// sourceLocManager does.
+static void checkAgainstManager(LineTable &table)
+{
+  int len = strlen(text);
+  for (int hashLines = 0; hashLines <= 1; hashLines++) {
+    sourceLocManager->useHashLines = !!hashLines;
+
+    for (int offset = 0; offset < len; offset++) {
+      SourceLoc loc = locAt(offset);
+
+      DecodedLoc d;
+      xassert(table.tryDecode(loc, d));
+
+      char const *expectFname;
+      int expectLine, expectCol;
+      sourceLocManager->decodeLineCol(loc, expectFname, expectLine, expectCol);
+
+      if (0!=strcmp(d.m_fname, expectFname) ||
+          d.m_line != expectLine ||
+          d.m_col != expectCol) {
+        cout << "offset " << offset << " (hashLines=" << hashLines
+             << "): got " << d.m_fname << ":" << d.m_line << ":" << d.m_col
+             << ", expected " << expectFname << ":" << expectLine
+             << ":" << expectCol << endl;
+        xfailure("decode mismatch");
+      }
+    }
+  }
+  sourceLocManager->useHashLines = true;
+}
+
+
+// A few spot checks written out by hand, so the test does not rely
+// only on agreeing with sourceLocManager.
+static void checkKnownLocations(LineTable &table)
+{
+  sourceLocManager->useHashLines = true;
+
+  DecodedLoc d = table.decode(locAt(0));
+  xassert(0==strcmp(d.m_fname, fname) && d.m_line == 1 && d.m_col == 1);
+
+  // "int c;" is line 4, which the first directive calls foo.h:10
+  int offsetC = strstr(text, "int c;") - text;
+  d = table.decode(locAt(offsetC + 4));
+  xassert(0==strcmp(d.m_fname, "foo.h") && d.m_line == 10 && d.m_col == 5);
+
+  // "int d;" is two lines later
+  int offsetD = strstr(text, "int d;") - text;
+  d = table.decode(locAt(offsetD));
+  xassert(0==strcmp(d.m_fname, "foo.h") && d.m_line == 12 && d.m_col == 3);
+
+  // "int g;" is bar.h:2
+  int offsetG = strstr(text, "int g;") - text;
+  d = table.decode(locAt(offsetG));
+  xassert(0==strcmp(d.m_fname, "bar.h") && d.m_line == 2 && d.m_col == 1);
+
+  // without remapping, it is line 9 of the file itself
+  sourceLocManager->useHashLines = false;
+  d = table.decode(locAt(offsetG));
+  xassert(0==strcmp(d.m_fname, fname) && d.m_line == 9 && d.m_col == 1);
+  sourceLocManager->useHashLines = true;
+}
+
+
+// 'decodeMany' must give the same answers as 'decode', in the
+// caller's order, including for locations it has to fall back on.
+static void checkDecodeMany(LineTable &table)
+{
+  int len = strlen(text);
+
+  // every location backwards, interleaved with ones the table does
+  // not cover
+  std::vector<SourceLoc> locs;
+  for (int offset = len-1; offset >= 0; offset--) {
+    locs.push_back(locAt(offset));
+    if (offset % 7 == 0) {
+      locs.push_back(SL_UNKNOWN);
+    }
+  }
+
+  std::vector<DecodedLoc> out(locs.size());
+  table.decodeMany(locs.data(), locs.size(), out.data());
+
+  for (size_t i=0; i < locs.size(); i++) {
+    DecodedLoc d = table.decode(locs[i]);
+    xassert(0==strcmp(out[i].m_fname, d.m_fname));
+    xassert(out[i].m_line == d.m_line);
+    xassert(out[i].m_col == d.m_col);
+  }
+}
+
+
+// A file must be indexed only once, and text that does not pick up
+// where the last text ended, or that was never seen, is left to
+// sourceLocManager.
+static void checkCoverage(SourceLoc begin)
+{
+  {
+    LineTable table;
+    LineTable::File *f = table.beginFile(fname, begin);
+    xassert(f);
+    xassert(!table.beginFile(fname, begin));
+
+    // only part of the file
+    f->noteText(locAt(0), text, 10);
+    DecodedLoc d;
+    xassert(table.tryDecode(locAt(5), d));
+    xassert(table.tryDecode(locAt(10), d));     // end of the text seen
+    xassert(!table.tryDecode(locAt(11), d));
+    xassert(!table.tryDecode(SL_UNKNOWN, d));
+  }
+
+  {
+    LineTable table;
+    LineTable::File *f = table.beginFile(fname, begin);
+
+    // a gap breaks the file
+    f->noteText(locAt(0), text, 5);
+    f->noteText(locAt(7), text+7, 3);
+    DecodedLoc d;
+    xassert(!table.tryDecode(locAt(2), d));
+
+    // but 'decode' still answers, via sourceLocManager
+    d = table.decode(locAt(2));
+    xassert(d.m_line == 1 && d.m_col == 3);
+  }
+}
+
+
+int main()
+{
+  SourceLocManager mgr;
+
+  FILE *fp = fopen(fname, "w");
+  xassert(fp);
+  fputs(text, fp);
+  fclose(fp);
+
+  SourceLoc begin = mgr.encodeBegin(fname);
+  SourceLocManager::File *srcFile = mgr.getInternalFile(fname);
+  srcFile->addHashLine(3, 10, "foo.h");
+  srcFile->addHashLine(7, 1, "bar.h");
+
+  LineTable table;
+  LineTable::File *f = table.beginFile(fname, begin);
+  xassert(f);
+  feed(f, strlen(text));
+
+  checkAgainstManager(table);
+  checkKnownLocations(table);
+  checkDecodeMany(table);
+  checkCoverage(begin);
+
+  remove(fname);
+
+  cout << "line-table_test: PASS.\n"
+       << flush;
+  return 0;
+}
+
+
+// EOF
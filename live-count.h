@@ -0,0 +1,68 @@
+// live-count.h
+// LiveCount<T>, a mix-in that counts instances of T.
+
+#ifndef ELSA_LIVE_COUNT_H
+#define ELSA_LIVE_COUNT_H
+
+#include <stddef.h>                    // size_t
+
+
+// Default to on; "./configure -release" turns it off.
+#ifndef ELSA_OBJECT_COUNTS
+  #define ELSA_OBJECT_COUNTS 1
+#endif
+
+#if ELSA_OBJECT_COUNTS!=0 && ELSA_OBJECT_COUNTS!=1
+  #error ELSA_OBJECT_COUNTS defined but not 0 or 1
+#endif
+
+
+// Inheriting (privately) from LiveCount<T> makes T keep a count of
+// how many instances currently exist and how many have ever been
+// made, for memory accounting (see mem-stats.h).  The base is empty,
+// so it does not change sizeof(T).
+//
+// Counts include objects of classes derived from T.
+//
+// When ELSA_OBJECT_COUNTS is 0, the constructors and destructor do
+// nothing and the counts stay 0, so the base costs nothing at all.
+template <class T>
+class LiveCount {
+public:      // class data
+  // Number of instances constructed but not yet destroyed.
+  static size_t s_numLive;
+
+  // Number of instances ever constructed.
+  static size_t s_numCreated;
+
+protected:   // funcs
+#if ELSA_OBJECT_COUNTS
+  LiveCount()
+  {
+    s_numLive++;
+    s_numCreated++;
+  }
+
+  LiveCount(LiveCount const &)
+  {
+    s_numLive++;
+    s_numCreated++;
+  }
+
+  LiveCount& operator= (LiveCount const &) { return *this; }
+
+  ~LiveCount()
+  {
+    s_numLive--;
+  }
+#endif // ELSA_OBJECT_COUNTS
+};
+
+template <class T>
+size_t LiveCount<T>::s_numLive = 0;
+
+template <class T>
+size_t LiveCount<T>::s_numCreated = 0;
+
+
+#endif // ELSA_LIVE_COUNT_H
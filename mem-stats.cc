@@ -0,0 +1,248 @@
+// mem-stats.cc
+// code for mem-stats.h
+
+#include "mem-stats.h"                 // this module
+
+// elsa
+#include "cc-ast.h"                    // ASTVisitor
+#include "cc-ast-aux.h"                // LoweredASTVisitor
+#include "cc-err.h"                    // ErrorMsg
+#include "cc-scope.h"                  // Scope
+#include "cc-type.h"                   // Type, etc.
+#include "live-count.h"                // LiveCount, ELSA_OBJECT_COUNTS
+#include "serialno.h"                  // USE_SERIAL_NUMBERS
+#include "template.h"                  // TemplateInfo, etc.
+#include "variable.h"                  // Variable
+
+// libc++
+#include <map>                         // std::map
+#include <string>                      // std::string
+
+// libc
+#if defined(__GLIBC__)
+  #include <malloc.h>                  // malloc_usable_size
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>            // getrusage
+#endif
+
+
+// Heap block size of 'p', or 0 if that is not available.
+static size_t heapBlockSize(void const *p)
+{
+  #if defined(__GLIBC__)
+    return malloc_usable_size(const_cast<void*>(p));
+  #else
+    return 0;
+  #endif
+}
+
+
+size_t peakRSSBytes()
+{
+  #if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      return 0;
+    }
+    #if defined(__APPLE__)
+      return usage.ru_maxrss;            // already in bytes
+    #else
+      return usage.ru_maxrss * 1024;     // kilobytes
+    #endif
+  #else
+    return 0;
+  #endif
+}
+
+
+// Tallies AST nodes by kind.  Since it works by traversal, it sees
+// the nodes reachable from where the traversal starts, not every node
+// that is alive.
+class ASTNodeCounter : public ASTVisitor {
+public:      // types
+  struct Tally {
+    size_t m_count;
+    size_t m_bytes;
+
+    Tally() : m_count(0), m_bytes(0) {}
+  };
+
+public:      // data
+  // Map from kind name to its tally.  A std::map so the report comes
+  // out sorted.
+  std::map<std::string, Tally> m_tallies;
+
+public:      // funcs
+  ASTNodeCounter()
+    : m_tallies()
+  {}
+
+  void add(char const *kind, void const *node)
+  {
+    Tally &t = m_tallies[kind];
+    t.m_count++;
+    t.m_bytes += heapBlockSize(node);
+  }
+
+  // ASTVisitor functions
+
+  // superclass with subclasses; tally by subclass
+  #define COUNT_KIND(type)                       \
+    bool visit##type(type *obj) override         \
+    {                                            \
+      add(obj->kindName(), obj);                 \
+      return true;                               \
+    }
+
+  // class without subclasses
+  #define COUNT_LEAF(type)                       \
+    bool visit##type(type *obj) override         \
+    {                                            \
+      add(#type, obj);                           \
+      return true;                               \
+    }
+
+  COUNT_LEAF(TranslationUnit)
+  COUNT_KIND(TopForm)
+  COUNT_LEAF(Function)
+  COUNT_LEAF(MemberInit)
+  COUNT_LEAF(Declaration)
+  COUNT_LEAF(ASTTypeId)
+  COUNT_KIND(PQName)
+  COUNT_KIND(TypeSpecifier)
+  COUNT_LEAF(BaseClassSpec)
+  COUNT_LEAF(Enumerator)
+  COUNT_LEAF(MemberList)
+  COUNT_KIND(Member)
+  COUNT_LEAF(Declarator)
+  COUNT_KIND(IDeclarator)
+  COUNT_LEAF(ExceptionSpec)
+  COUNT_KIND(OperatorName)
+  COUNT_KIND(Statement)
+  COUNT_KIND(Condition)
+  COUNT_LEAF(Handler)
+  COUNT_KIND(AsmDefinition)
+  COUNT_KIND(Expression)
+  COUNT_LEAF(FullExpression)
+  COUNT_LEAF(ArgExpression)
+  COUNT_LEAF(ArgExpressionListOpt)
+  COUNT_KIND(Initializer)
+  COUNT_KIND(Designator)
+  COUNT_KIND(TemplateDeclaration)
+  COUNT_KIND(TemplateParameter)
+  COUNT_KIND(TemplateArgument)
+  COUNT_KIND(NamespaceDecl)
+  COUNT_LEAF(FullExpressionAnnot)
+
+  #ifdef GNU_EXTENSION
+    // gnu.ast
+    COUNT_KIND(ASTTypeof)
+    COUNT_LEAF(GNUAsmOperand)
+    COUNT_LEAF(AttributeSpecifierList)
+    COUNT_LEAF(AttributeSpecifier)
+    COUNT_KIND(Attribute)
+  #endif // GNU_EXTENSION
+
+  #undef COUNT_KIND
+  #undef COUNT_LEAF
+};
+
+
+static void printRow(ostream &os, char const *phase, char const *category,
+                     char const *name, size_t count, size_t bytes)
+{
+  os << "memstats " << phase << " " << category << " " << name
+     << " " << count << " " << bytes << "\n";
+}
+
+
+void printMemStats(ostream &os, char const *phase,
+                   TranslationUnit *unit, bool lowered)
+{
+  if (unit) {
+    ASTNodeCounter counter;
+    if (lowered) {
+      LoweredASTVisitor loweredVisitor(&counter, VF_VISIT_ELAB);
+      unit->traverse(loweredVisitor);
+    }
+    else {
+      unit->traverse(counter);
+    }
+
+    for (auto const &kv : counter.m_tallies) {
+      printRow(os, phase, "ast-reachable", kv.first.c_str(),
+               kv.second.m_count, kv.second.m_bytes);
+    }
+  }
+
+#if ELSA_OBJECT_COUNTS
+  #define LIVE_ROW(category, T)                                  \
+    printRow(os, phase, category, #T, LiveCount<T>::s_numLive,   \
+             LiveCount<T>::s_numLive * sizeof(T));
+
+  LIVE_ROW("type", SimpleType)
+  LIVE_ROW("type", CompoundType)
+  LIVE_ROW("type", EnumType)
+  LIVE_ROW("type", TypeVariable)
+  LIVE_ROW("type", PseudoInstantiation)
+  LIVE_ROW("type", DependentQType)
+  LIVE_ROW("type", CVAtomicType)
+  LIVE_ROW("type", PointerType)
+  LIVE_ROW("type", ReferenceType)
+  LIVE_ROW("type", FunctionType)
+  LIVE_ROW("type", ArrayType)
+  LIVE_ROW("type", PointerToMemberType)
+  LIVE_ROW("type", TypedefType)
+
+  LIVE_ROW("object", Variable)
+  printRow(os, phase, "object", "Variable::ColdFields",
+           Variable::numColdFields,
+           Variable::numColdFields * Variable::sizeofColdFields);
+  LIVE_ROW("object", Scope)
+  LIVE_ROW("object", TemplateInfo)
+  LIVE_ROW("object", ErrorMsg)
+  LIVE_ROW("object", STemplateArgument)
+
+  #undef LIVE_ROW
+#endif // ELSA_OBJECT_COUNTS
+
+  printRow(os, phase, "process", "peakRSS", 1, peakRSSBytes());
+}
+
+
+void printSizeReport(ostream &os)
+{
+  os << "sizereport config USE_SERIAL_NUMBERS " << USE_SERIAL_NUMBERS << "\n"
+     << "sizereport config ELSA_OBJECT_COUNTS " << ELSA_OBJECT_COUNTS << "\n";
+
+  #define SIZE_ROW(T) \
+    os << "sizereport sizeof " #T " " << sizeof(T) << "\n";
+
+  SIZE_ROW(SimpleType)
+  SIZE_ROW(CompoundType)
+  SIZE_ROW(EnumType)
+  SIZE_ROW(TypeVariable)
+  SIZE_ROW(PseudoInstantiation)
+  SIZE_ROW(DependentQType)
+  SIZE_ROW(CVAtomicType)
+  SIZE_ROW(PointerType)
+  SIZE_ROW(ReferenceType)
+  SIZE_ROW(FunctionType)
+  SIZE_ROW(ArrayType)
+  SIZE_ROW(PointerToMemberType)
+  SIZE_ROW(TypedefType)
+
+  SIZE_ROW(Variable)
+  os << "sizereport sizeof Variable::ColdFields "
+     << Variable::sizeofColdFields << "\n";
+  SIZE_ROW(Scope)
+  SIZE_ROW(TemplateInfo)
+  SIZE_ROW(ErrorMsg)
+  SIZE_ROW(STemplateArgument)
+
+  #undef SIZE_ROW
+}
+
+
+// EOF
@@ -0,0 +1,66 @@
+// mem-stats.h
+// Per-phase memory accounting, printed by "-tr memstats".
+
+#ifndef ELSA_MEM_STATS_H
+#define ELSA_MEM_STATS_H
+
+// elsa
+#include "cc-ast-fwd.h"                // TranslationUnit
+
+// smbase
+#include "sm-ostream.h"                // ostream
+
+// libc
+#include <stddef.h>                    // size_t
+
+
+// Print a memory report describing the state at the end of 'phase'
+// (e.g., "parse", "tcheck").  Every line has the form
+//
+//   memstats <phase> <category> <name> <count> <bytes>
+//
+// with single spaces between fields, so the output can be extracted
+// with "grep ^memstats" and compared across releases.  <category> is
+// one of:
+//
+//   ast-reachable  AST nodes reachable from 'unit', by node kind.
+//                  Nodes that are alive but unreachable, such as
+//                  discarded ambiguity alternatives that were not
+//                  freed, are not counted.  <bytes> is the size of the
+//                  heap blocks holding them, where the allocator can
+//                  report that, and 0 otherwise.
+//   type           Live Type and AtomicType objects, by class.
+//   object         Live Variables, Scopes, TemplateInfos, ErrorMsgs
+//                  and STemplateArguments.  Scope counts include
+//                  CompoundTypes.
+//   process        Peak resident set size, with <count> 1.
+//
+// For 'type' and 'object', <bytes> is count * sizeof, which excludes
+// storage hanging off the objects (lists, maps, strings).  Those two
+// categories are omitted when ELSA_OBJECT_COUNTS is 0, since the
+// objects are then not counted.
+//
+// 'unit' may be NULL, in which case no 'ast-reachable' lines are
+// printed.  If
+// 'lowered', the AST walk includes template instantiations and
+// elaborated subtrees, which is only possible after a successful
+// type check.
+void printMemStats(ostream &os, char const *phase,
+                   TranslationUnit *unit, bool lowered);
+
+// Print, for "-tr sizeReport", the build configuration and the size
+// of each class counted by 'printMemStats', as lines of the form
+//
+//   sizereport config <macro> <value>
+//   sizereport sizeof <class> <bytes>
+//
+// Comparing the output of two builds (see 'release-check') shows the
+// per-object bytes that the release configuration saves.
+void printSizeReport(ostream &os);
+
+// Peak resident set size of this process in bytes, or 0 if the
+// platform does not say.
+size_t peakRSSBytes();
+
+
+#endif // ELSA_MEM_STATS_H
@@ -13,6 +13,7 @@
 #include "mtype.h"       // this module
 #include "trace.h"       // tracingSys
 #include "cc-env.h"      // Env::applyArgumentMap
+#include "sm-stdint.h"   // uintptr_t
 
 
 string toString(MatchFlags flags)
@@ -1284,4 +1285,110 @@ void MType::setBoundValue(StringRef name, STemplateArgument const &value)
 }
 
 
+// ----------------------- TypeEqualityCache -------------------------
+size_t TypeEqualityCache::KeyHash::operator() (Key const &k) const
+{
+  size_t h = (size_t)(uintptr_t)k.m_t1;
+  h = h*31 + (size_t)(uintptr_t)k.m_t2;
+  h = h*31 + (size_t)k.m_flags;
+  h = h*31 + (size_t)k.m_kind;
+  return h;
+}
+
+
+TypeEqualityCache::TypeEqualityCache(size_t capacity)
+  : m_results(),
+    m_capacity(capacity),
+    m_numQueries(0),
+    m_numHits(0),
+    m_numUncacheable(0),
+    m_numFlushes(0),
+    m_numInvalidations(0),
+    m_prevActive(NULL)
+{}
+
+TypeEqualityCache::~TypeEqualityCache()
+{
+  xassert(s_active != this);
+}
+
+
+TypeEqualityCache *TypeEqualityCache::s_active = NULL;
+
+
+void TypeEqualityCache::activate()
+{
+  m_prevActive = s_active;
+  s_active = this;
+}
+
+
+void TypeEqualityCache::deactivate()
+{
+  xassert(s_active == this);
+  s_active = m_prevActive;
+  m_prevActive = NULL;
+}
+
+
+void TypeEqualityCache::invalidate()
+{
+  m_results.clear();
+  m_numInvalidations++;
+}
+
+
+bool TypeEqualityCache::lookup(Type const *t1, Type const *t2,
+                               MatchFlags flags, Kind kind,
+                               bool &cacheable, bool &result)
+{
+  m_numQueries++;
+
+  Key key = { t1, t2, flags, kind };
+  auto it = m_results.find(key);
+  if (it != m_results.end()) {
+    m_numHits++;
+    cacheable = true;
+    result = it->second;
+    return true;
+  }
+
+  // Types with variables compare differently depending on which
+  // template parameters have been associated with templates, which
+  // changes over time.
+  cacheable = !t1->containsVariables() && !t2->containsVariables();
+  if (!cacheable) {
+    m_numUncacheable++;
+  }
+  return false;
+}
+
+
+void TypeEqualityCache::insert(Type const *t1, Type const *t2,
+                               MatchFlags flags, Kind kind, bool result)
+{
+  if (m_results.size() >= m_capacity) {
+    m_results.clear();
+    m_numFlushes++;
+  }
+
+  Key key = { t1, t2, flags, kind };
+  m_results[key] = result;
+}
+
+
+void TypeEqualityCache::printStats(ostream &os) const
+{
+  os << "type equality queries: " << m_numQueries << "\n"
+     << "type equality hits: " << m_numHits;
+  if (m_numQueries) {
+    os << " (" << (m_numHits * 100 / m_numQueries) << "%)";
+  }
+  os << "\n"
+     << "type equality uncacheable: " << m_numUncacheable << "\n"
+     << "type equality flushes: " << m_numFlushes << "\n"
+     << "type equality invalidations: " << m_numInvalidations << "\n";
+}
+
+
 // EOF
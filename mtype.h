@@ -13,6 +13,8 @@
 #include "cc-env-fwd.h"         // Env
 #include "template.h"           // STemplateArgument
 
+#include <unordered_map>        // std::unordered_map
+
 
 // Internal MType: the core of the MType implementation, separated
 // into its own class so that it cannot (easily, accidentally) use the
@@ -236,4 +238,105 @@ public:      // funcs
 };
 
 
+// Bounded memo of the results of type equality queries, i.e., those
+// that only want a yes/no answer and not the bindings.  Only pairs of
+// types that contain no type variables are remembered, since the
+// result for those depends only on the structure of the types.
+//
+// That structure is fixed once a type is built, with a few exceptions
+// in Env::createDeclaration (completing an array size, merging
+// FF_VARARGS), which call 'invalidate'.  FunctionTypes are filled in
+// with 'addParam' before they are compared with anything.
+//
+// Entries are keyed by address, so a cache must not outlive the
+// types it has seen.  Each Env has one.
+class TypeEqualityCache {
+  NO_OBJECT_COPIES(TypeEqualityCache);
+
+public:      // types
+  // Which comparison was performed, since the same pair of types and
+  // flags can be given to comparisons with different semantics.
+  enum Kind {
+    K_MATCH_TYPE,               // MType::matchType
+    K_EQUIVALENT_TYPES,         // Env::equivalentTypes
+    NUM_KINDS
+  };
+
+private:     // types
+  struct Key {
+    Type const *m_t1;
+    Type const *m_t2;
+    MatchFlags m_flags;
+    Kind m_kind;
+
+    bool operator== (Key const &obj) const
+    {
+      return m_t1 == obj.m_t1 && m_t2 == obj.m_t2 &&
+             m_flags == obj.m_flags && m_kind == obj.m_kind;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator() (Key const &k) const;
+  };
+
+private:     // data
+  // Cached results.
+  std::unordered_map<Key, bool, KeyHash> m_results;
+
+  // Maximum number of entries in 'm_results'.  When it fills up, it
+  // is simply emptied.
+  size_t m_capacity;
+
+  // Number of 'lookup' calls, and how many of them found an entry.
+  unsigned long m_numQueries;
+  unsigned long m_numHits;
+
+  // Number of queries not cached because a type had variables.
+  unsigned long m_numUncacheable;
+
+  // Number of times the table was emptied for being full.
+  unsigned long m_numFlushes;
+
+  // Number of calls to 'invalidate'.
+  unsigned long m_numInvalidations;
+
+  // The cache that was active before 'activate' was called on this one.
+  TypeEqualityCache *m_prevActive;
+
+  // See 'active'.
+  static TypeEqualityCache *s_active;
+
+public:      // funcs
+  explicit TypeEqualityCache(size_t capacity);
+  ~TypeEqualityCache();
+
+  // The cache consulted by 'BaseType::equals', which has no Env to
+  // ask, or NULL if none.  An Env makes its cache the active one for
+  // its lifetime.
+  static TypeEqualityCache *active() { return s_active; }
+
+  // Make this the active cache, until 'deactivate' restores the
+  // previous one.  Calls must nest.
+  void activate();
+  void deactivate();
+
+  // Forget everything, because a type has been modified in place.
+  void invalidate();
+
+  // If the result of comparing 't1' and 't2' is known, put it in
+  // 'result' and return true.  Otherwise return false; if the pair
+  // is cacheable, 'cacheable' is set so the caller knows to 'insert'
+  // the result afterward.
+  bool lookup(Type const *t1, Type const *t2, MatchFlags flags, Kind kind,
+              bool &cacheable, bool &result);
+
+  // Record a result for a pair for which 'lookup' set 'cacheable'.
+  void insert(Type const *t1, Type const *t2, MatchFlags flags, Kind kind,
+              bool result);
+
+  void printStats(ostream &os) const;
+};
+
+
 #endif // MTYPE_H
@@ -10,6 +10,9 @@
 
 class ArgumentInfo;
 class Candidate;
+class CandidatePool;
+class ConversionOperatorCache;
+class OverloadStats;
 class OverloadResolver;
 class InstCandidate;
 class InstCandidateResolver;
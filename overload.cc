@@ -14,22 +14,72 @@
 #include "typelistiter.h"  // TypeListIter
 #include "strtokp.h"       // StrtokParse
 #include "mtype.h"         // MType
+#include "sm-stdint.h"     // uintptr_t
+
+#include <algorithm>       // std::sort
+#include <vector>          // std::vector
 
 
 // ------------------- Candidate -------------------------
 Candidate::Candidate(Variable *v, Variable *instFrom0, int numArgs)
-  : var(v)
-  , instFrom(instFrom0)
-  , conversions(numArgs)
-{}
+  : m_heapConversions(NULL)
+  , m_heapCapacity(0)
+  , m_heapKeys(NULL)
+  , m_numConversions(0)
+  , var(NULL)
+  , instFrom(NULL)
+  , conversions(m_inlineConversions)
+  , keys(m_inlineKeys)
+{
+  reset(v, instFrom0, numArgs);
+}
 
 Candidate::~Candidate()
-{}
+{
+  delete[] m_heapConversions;
+  delete[] m_heapKeys;
+}
+
+
+void Candidate::reset(Variable *v, Variable *instFrom0, int numArgs)
+{
+  var = v;
+  instFrom = instFrom0;
+  m_numConversions = numArgs;
+
+  if (numArgs <= NUM_INLINE_CONVERSIONS) {
+    conversions = m_inlineConversions;
+    keys = m_inlineKeys;
+  }
+  else {
+    if (numArgs > m_heapCapacity) {
+      delete[] m_heapConversions;
+      delete[] m_heapKeys;
+      m_heapConversions = new ImplicitConversion[numArgs];
+      m_heapKeys = new unsigned char[numArgs];
+      m_heapCapacity = numArgs;
+    }
+    conversions = m_heapConversions;
+    keys = m_heapKeys;
+  }
+
+  for (int i=0; i < numArgs; i++) {
+    conversions[i] = ImplicitConversion();
+  }
+}
+
+
+void Candidate::computeRankKeys()
+{
+  for (int i=0; i < m_numConversions; i++) {
+    keys[i] = conversionRankKey(conversions[i]);
+  }
+}
 
 
 bool Candidate::hasAmbigConv() const
 {
-  for (int i=0; i < conversions.allocatedSize(); i++) {
+  for (int i=0; i < m_numConversions; i++) {
     if (conversions[i].isAmbiguous()) {
       return true;
     }
@@ -40,7 +90,7 @@ bool Candidate::hasAmbigConv() const
 
 void Candidate::conversionDescriptions() const
 {
-  for (int i=0; i < conversions.allocatedSize(); i++) {
+  for (int i=0; i < m_numConversions; i++) {
     OVERLOADTRACE(i << ": " << toString(conversions[i]));
   }
 }
@@ -128,6 +178,37 @@ Type *OverloadResolver::getReturnType(Candidate const *winner) const
 }
 
 
+// ------------------- CandidatePool -------------------------
+CandidatePool::CandidatePool()
+  : m_free()
+{}
+
+CandidatePool::~CandidatePool()
+{
+  for (int i=0; i < m_free.length(); i++) {
+    delete m_free[i];
+  }
+}
+
+
+Candidate *CandidatePool::alloc(Variable *v, Variable *instFrom, int numArgs)
+{
+  if (m_free.isEmpty()) {
+    return new Candidate(v, instFrom, numArgs);
+  }
+
+  Candidate *c = m_free.pop();
+  c->reset(v, instFrom, numArgs);
+  return c;
+}
+
+
+void CandidatePool::release(Candidate *c)
+{
+  m_free.push(c);
+}
+
+
 // ------------------ resolveOverload --------------------
 // prototypes
 int compareConversions(ArgumentInfo const &src,
@@ -184,8 +265,15 @@ OverloadResolver::OverloadResolver
     // low, then the 'candidates' array will have to be resized
     // at some point; it's entirely a performance issue
     candidates(numCand),
-    origCandidates(numCand)
+    origCandidates(numCand),
+    m_stats(env.overloadStats()),
+    m_startTime(),
+    m_numCandidates(0)
 {
+  if (m_stats) {
+    m_startTime = std::chrono::steady_clock::now();
+  }
+
   //overloadNesting++;
 
   // part of 14.7.1 para 4: If any argument types is a reference to a
@@ -308,6 +396,110 @@ string OverloadResolver::argInfoString()
 OverloadResolver::~OverloadResolver()
 {
   //overloadNesting--;
+
+  if (m_stats) {
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - m_startTime;
+    m_stats->recordResolution(loc,
+      origCandidates.isEmpty()? NULL : origCandidates[0]->name,
+      m_numCandidates, elapsed.count());
+  }
+
+  for (int i=0; i < candidates.length(); i++) {
+    env.candidatePool().release(candidates[i]);
+  }
+}
+
+
+// ------------------- OverloadStats -------------------------
+OverloadStats::OverloadStats()
+  : m_numResolutions(0),
+    m_numCandidates(0),
+    m_numViable(0),
+    m_numTemplatesDeduced(0),
+    m_numDeductionFailures(0),
+    m_numBuiltinCandidates(0),
+    m_numUserConversions(0),
+    m_numNoViable(0),
+    m_numAmbiguous(0),
+    m_numSelected(0),
+    m_seconds(0),
+    m_bySite(),
+    m_bySet()
+{}
+
+OverloadStats::~OverloadStats()
+{}
+
+
+void OverloadStats::recordResolution(SourceLoc loc, StringRef setName,
+  unsigned long numCandidates, double seconds)
+{
+  m_numResolutions++;
+  m_seconds += seconds;
+
+  Aggregate &site = m_bySite[loc];
+  site.m_numResolutions++;
+  site.m_numCandidates += numCandidates;
+  site.m_seconds += seconds;
+
+  Aggregate &set = m_bySet[setName];
+  set.m_numResolutions++;
+  set.m_numCandidates += numCandidates;
+  set.m_seconds += seconds;
+}
+
+
+// print the 'topN' entries of 'map' with the greatest total time
+template <class KEY>
+static void printTopAggregates(ostream &os, char const *title, int topN,
+  std::unordered_map<KEY, OverloadStats::Aggregate> const &map,
+  string (*keyToString)(KEY))
+{
+  typedef std::pair<KEY, OverloadStats::Aggregate> Entry;
+  std::vector<Entry> entries(map.begin(), map.end());
+  std::sort(entries.begin(), entries.end(),
+    [](Entry const &a, Entry const &b) {
+      return a.second.m_seconds > b.second.m_seconds;
+    });
+
+  os << "top " << title << " by time:\n";
+  for (int i=0; i < topN && i < (int)entries.size(); i++) {
+    OverloadStats::Aggregate const &agg = entries[i].second;
+    os << "  " << keyToString(entries[i].first)
+       << ": " << agg.m_numResolutions << " resolutions, "
+       << agg.m_numCandidates << " candidates, "
+       << (agg.m_seconds * 1000.0) << " ms\n";
+  }
+}
+
+static string siteToString(SourceLoc loc)
+{
+  return toString(loc);
+}
+
+static string setToString(StringRef name)
+{
+  return name? string(name) : string("(no candidates)");
+}
+
+
+void OverloadStats::print(ostream &os, int topN) const
+{
+  os << "overload resolutions: " << m_numResolutions << "\n"
+     << "overload candidates considered: " << m_numCandidates << "\n"
+     << "overload candidates viable: " << m_numViable << "\n"
+     << "overload template deductions: " << m_numTemplatesDeduced << "\n"
+     << "overload template deduction failures: " << m_numDeductionFailures << "\n"
+     << "overload built-in candidates: " << m_numBuiltinCandidates << "\n"
+     << "overload user conversions attempted: " << m_numUserConversions << "\n"
+     << "overload outcomes: " << m_numSelected << " selected, "
+       << m_numAmbiguous << " ambiguous, "
+       << m_numNoViable << " no viable candidate\n"
+     << "overload resolution time: " << (m_seconds * 1000.0) << " ms\n";
+
+  printTopAggregates(os, "overload call sites", topN, m_bySite, &siteToString);
+  printTopAggregates(os, "overload sets", topN, m_bySet, &setToString);
 }
 
 
@@ -327,6 +519,9 @@ void OverloadResolver::addCandidate(Variable *var0, Variable *instFrom)
   if (c) {
     IFDEBUG( c->conversionDescriptions(); )
     candidates.push(c);
+    if (m_stats) {
+      m_stats->m_numViable++;
+    }
 
     // part of 14.7.1 para 4: If a candidate function parameter is
     // (a reference to) a template class instantiation, force its body
@@ -360,6 +555,11 @@ void OverloadResolver::processCandidate(Variable *v)
   OVERLOADINDTRACE("candidate: " << v->toString() <<
                    " at " << toString(v->loc));
 
+  if (m_stats) {
+    m_stats->m_numCandidates++;
+    m_numCandidates++;
+  }
+
   if ((flags & OF_NO_EXPLICIT) && v->hasFlag(DF_EXPLICIT)) {
     // not a candidate, we're ignoring explicit constructors
     OVERLOADTRACE("(not viable due to 'explicit')");
@@ -424,8 +624,14 @@ void OverloadResolver::processCandidate(Variable *v)
     if (!env.getFuncTemplArgs(match, sargs, finalName, v, argListIter, iflags)) {
       // something doesn't work about processing the template arguments
       OVERLOADTRACE("(not viable because args to not match template params)");
+      if (m_stats) {
+        m_stats->m_numDeductionFailures++;
+      }
       return;
     }
+    if (m_stats) {
+      m_stats->m_numTemplatesDeduced++;
+    }
   }
 
   // FIX: the following is copied from Env::findMostSpecific(); it
@@ -464,7 +670,7 @@ void OverloadResolver::processPossiblyOverloadedVar(Variable *v)
 
 void OverloadResolver::addAmbiguousBinaryCandidate(Variable *v)
 {
-  Candidate *c = new Candidate(v, NULL /*instFrom*/, 2);
+  Candidate *c = env.candidatePool().alloc(v, NULL /*instFrom*/, 2);
   c->conversions[0].addAmbig();
   c->conversions[1].addAmbig();
 
@@ -593,9 +799,21 @@ void OverloadResolver::addBuiltinUnaryCandidates(OverloadableOp op)
 void OverloadResolver::addBuiltinBinaryCandidates(OverloadableOp op,
   ArgumentInfo &lhsInfo, ArgumentInfo &rhsInfo)
 {
-  ObjArrayStack<CandidateSet> &builtins = env.builtinBinaryOperator[op];
-  for (int i=0; i < builtins.length(); i++) {
-    builtins[i]->instantiateBinary(env, *this, op, lhsInfo, rhsInfo);
+  BuiltinCandidateCache &cache = env.builtinCandidateCache();
+
+  BuiltinCandidateList scratch;
+  BuiltinCandidateList const &builtins =
+    cache.getCandidates(env, op, lhsInfo, rhsInfo, scratch);
+  if (m_stats) {
+    m_stats->m_numBuiltinCandidates += builtins.size();
+  }
+  for (size_t i=0; i < builtins.size(); i++) {
+    if (builtins[i].m_ambiguous) {
+      addAmbiguousBinaryCandidate(builtins[i].m_var);
+    }
+    else {
+      processCandidate(builtins[i].m_var);
+    }
   }
 }
 
@@ -715,6 +933,9 @@ Candidate const *OverloadResolver::resolveCandidate(bool &wasAmbig)
       errors->addError(new ErrorMsg(loc, sb, EF_NONE));
     }
     OVERLOADTRACE("no viable candidates");
+    if (m_stats) {
+      m_stats->m_numNoViable++;
+    }
     return NULL;
   }
 
@@ -724,6 +945,10 @@ Candidate const *OverloadResolver::resolveCandidate(bool &wasAmbig)
     OVERLOADTRACE("finalDestType: " << finalDestType->toString());
   }
 
+  for (int i=0; i<candidates.length(); i++) {
+    candidates[i]->computeRankKeys();
+  }
+
   // use a tournament to select a candidate that is not worse
   // than any of those it faced
   Candidate const *winner = selectBestCandidate(*this, (Candidate const*)NULL);
@@ -749,6 +974,9 @@ Candidate const *OverloadResolver::resolveCandidate(bool &wasAmbig)
 
   ambig_bail:
     OVERLOADTRACE("ambiguous overload");
+    if (m_stats) {
+      m_stats->m_numAmbiguous++;
+    }
     wasAmbig = true;
     return NULL;
   }
@@ -770,10 +998,16 @@ Candidate const *OverloadResolver::resolveCandidate(bool &wasAmbig)
         loc, "ambiguous overload or ambiguous conversion", EF_NONE));
     }
     OVERLOADTRACE("ambiguous overload or ambiguous conversion");
+    if (m_stats) {
+      m_stats->m_numAmbiguous++;
+    }
     wasAmbig = true;
     return NULL;
   }
 
+  if (m_stats) {
+    m_stats->m_numSelected++;
+  }
   return winner;
 }
 
@@ -820,15 +1054,24 @@ Variable *OverloadResolver::resolve()
 
 
 // for each parameter, determine an ICS, and return the resulting
-// Candidate; return NULL if the function isn't viable; this
-// implements C++98 13.3.2
-Candidate * /*owner*/ OverloadResolver::makeCandidate
+// Candidate, which belongs to 'env.candidatePool()'; return NULL if
+// the function isn't viable; this implements C++98 13.3.2
+Candidate * /*serf*/ OverloadResolver::makeCandidate
   (Variable *var, Variable *instFrom)
 {
   origCandidates.push(var);
-  Owner<Candidate> c(new Candidate(var, instFrom, args.allocatedSize()));
+  Candidate *c = env.candidatePool().alloc(var, instFrom, args.allocatedSize());
+  if (!computeConversions(c)) {
+    env.candidatePool().release(c);
+    return NULL;
+  }
+  return c;
+}
 
-  FunctionType *ft = var->type->asFunctionType();
+// fill in 'c->conversions'; return false if 'c' is not viable
+bool OverloadResolver::computeConversions(Candidate *c)
+{
+  FunctionType *ft = c->var->type->asFunctionType();
 
   // simultaneously iterate over parameters and arguments
   SObjListIter<Variable> paramIter(ft->params);
@@ -838,7 +1081,7 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
   if (flags & OF_METHODS) {      // receiver is present
     if (!args[argIndex].type && ft->isMethod()) {
       // no receiver object but function is a method: not viable
-      return NULL;
+      return false;
     }
     if (!ft->isMethod()) {
       // no receiver parameter; leave the conversion as IC_NONE
@@ -866,7 +1109,7 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
       }
       else {
         // whole thing not viable
-        return NULL;
+        return false;
       }
     }
 
@@ -884,10 +1127,16 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
         c->conversions[argIndex] = ics;
       }
       else {
-        return NULL;
+        return false;
       }
     }
     else {
+      if (m_stats &&
+          (args[argIndex].type->asRval()->isCompoundType() ||
+           paramIter.data()->type->asRval()->isCompoundType())) {
+        m_stats->m_numUserConversions++;
+      }
+
       // consider both standard and user-defined
       ImplicitConversion ics =
         getImplicitConversion(env, args[argIndex].special, args[argIndex].type,
@@ -896,7 +1145,7 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
         c->conversions[argIndex] = ics;
       }
       else {
-        return NULL;           // no conversion sequence possible
+        return false;           // no conversion sequence possible
       }
     }
   }
@@ -914,7 +1163,7 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
     }
     else {
       // too few arguments, cannot form a conversion
-      return NULL;
+      return false;
     }
   }
 
@@ -929,11 +1178,11 @@ Candidate * /*owner*/ OverloadResolver::makeCandidate
     else {
       // no default value, argument must be supplied but is not,
       // so cannot form a conversion
-      return NULL;
+      return false;
     }
   }
 
-  return c.xfr();
+  return true;
 }
 
 
@@ -1017,8 +1266,12 @@ int OverloadResolver::compareCandidates(Candidate const *left, Candidate const *
       rightParam.adv();
     }
 
-    int choice = compareConversions(args[i], left->conversions[i], leftDest,
-                                             right->conversions[i], rightDest);
+    // usually the kinds or ranks differ, which settles it
+    int choice;
+    if (!compareRankKeys(left->keys[i], right->keys[i], choice)) {
+      choice = compareConversions(args[i], left->conversions[i], leftDest,
+                                           right->conversions[i], rightDest);
+    }
     if (ret == 0) {
       // no decision so far, fold in this comparison
       ret = choice;
@@ -1160,6 +1413,79 @@ int compareConversions(ArgumentInfo const &src,
 }
 
 
+// layout of a rank key
+enum {
+  RK_RANK_MASK     = 0x03,    // SCRank of the (second) standard conversion
+  RK_GROUP_SHIFT   = 2,       // 13.3.3.2 para 2 group, as in 'compareConversions'
+  RK_GROUP_MASK    = 0x0C,
+  RK_AMBIGUOUS     = 0x10,    // IC_AMBIGUOUS
+};
+
+unsigned char conversionRankKey(ImplicitConversion const &ic)
+{
+  switch (ic.kind) {
+    default: xfailure("bad conversion kind");
+
+    case ImplicitConversion::IC_NONE:
+      return 0;
+
+    case ImplicitConversion::IC_STANDARD:
+      return (1 << RK_GROUP_SHIFT) | getRank(ic.scs);
+
+    case ImplicitConversion::IC_USER_DEFINED:
+      return (2 << RK_GROUP_SHIFT) | getRank(ic.scs2);
+
+    case ImplicitConversion::IC_ELLIPSIS:
+      return (3 << RK_GROUP_SHIFT);
+
+    case ImplicitConversion::IC_AMBIGUOUS:
+      return (2 << RK_GROUP_SHIFT) | RK_AMBIGUOUS;
+  }
+}
+
+
+// The rank test is exact even though 'compareStandardConversions'
+// checks for subsequences first: the rank of a sequence is that of its
+// group 2 component, so a subsequence never has a higher rank, and
+// when the ranks differ the subsequence test can only agree with them.
+bool compareRankKeys(unsigned char left, unsigned char right, int &choice)
+{
+  int leftGroup = (left & RK_GROUP_MASK) >> RK_GROUP_SHIFT;
+  int rightGroup = (right & RK_GROUP_MASK) >> RK_GROUP_SHIFT;
+  xassert(leftGroup && rightGroup);   // make sure neither is IC_NONE
+
+  // para 2
+  if (leftGroup != rightGroup) {
+    choice = leftGroup < rightGroup? -1 : +1;
+    return true;
+  }
+
+  if ((left | right) & RK_AMBIGUOUS) {
+    choice = 0;
+    return true;
+  }
+
+  switch (leftGroup) {
+    case 1: {      // para 3, bullet 1
+      int leftRank = left & RK_RANK_MASK;
+      int rightRank = right & RK_RANK_MASK;
+      if (leftRank != rightRank) {
+        choice = leftRank < rightRank? -1 : +1;
+        return true;
+      }
+      return false;
+    }
+
+    case 3:        // ellipsis
+      choice = 0;
+      return true;
+
+    default:       // para 3, bullet 2 depends on the conversion function
+      return false;
+  }
+}
+
+
 inline void swap(CompoundType const *&t1, CompoundType const *&t2)
 {
   CompoundType const *temp = t1;
@@ -1538,12 +1864,48 @@ bool isCompoundType_orConstRefTo(Type const *t)
   return false;
 }
 
+// Categories of conversion operator that might yield something that
+// can be standard-converted to the non-reference, non-class type
+// 'destType' (13.3.1.5).
+static ConversionOperatorKind relevantConversionKinds(Type const *destType)
+{
+  // templatized operators, and those yielding unusual types, always
+  // have to be tried
+  ConversionOperatorKind always = COK_TEMPLATE | COK_OTHER;
+
+  if (destType->isSimple(ST_BOOL)) {
+    return always | COK_BOOL_TESTABLE;
+  }
+  if (destType->isEnumType() ||
+      (destType->isSimpleType() &&
+       isArithmeticType(destType->asSimpleTypeC()->type))) {
+    return always | COK_ARITHMETIC;
+  }
+  if (destType->isPointerType() || destType->isPointerToMemberType()) {
+    return always | COK_POINTER;
+  }
+
+  return COK_ALL;
+}
+
 ImplicitConversion getConversionOperator(
   Env &env,
   SourceLoc loc,
   ErrorList * /*nullable*/ errors,
   Type *srcClassType,
   Type *destType
+) {
+  return env.conversionOperatorCache().get(env, loc, errors,
+                                            srcClassType, destType);
+}
+
+// the computation behind 'getConversionOperator'
+static ImplicitConversion getConversionOperator_uncached(
+  Env &env,
+  SourceLoc loc,
+  ErrorList * /*nullable*/ errors,
+  Type *srcClassType,
+  Type *destType
 ) {
   CompoundType *srcClass = srcClassType->asRval()->asCompoundType();
 
@@ -1566,8 +1928,9 @@ ImplicitConversion getConversionOperator(
                             NULL,
                             args);
 
-  // get the conversion operators for the source class
-  SObjList<Variable> &ops = srcClass->conversionOperators;
+  // the conversion operators for the source class, as relevant to
+  // each case below
+  ArrayStack<Variable*> ops;
 
   // 13.3.1.4?
   //
@@ -1582,8 +1945,9 @@ ImplicitConversion getConversionOperator(
     // Conversion functions that return 'reference to T' return
     // lvalues of type T and are therefore considered to yield T for
     // this process of selecting candidate functions."
-    SFOREACH_OBJLIST_NC(Variable, ops, iter) {
-      Variable *v = iter.data();
+    srcClass->getConversionOperators(ops, COK_CLASS | COK_TEMPLATE);
+    for (int i=0; i < ops.length(); i++) {
+      Variable *v = ops[i];
       Type *retType = v->type->asFunctionTypeC()->retType->asRval();
       if (!retType->containsVariables()) {
         // concrete type; easy case
@@ -1627,8 +1991,9 @@ ImplicitConversion getConversionOperator(
     // return 'reference to T' return lvalues of type T and are
     // therefore considered to yield T for this process of selecting
     // candidate functions."
-    SFOREACH_OBJLIST_NC(Variable, ops, iter) {
-      Variable *v = iter.data();
+    srcClass->getConversionOperators(ops, relevantConversionKinds(destType));
+    for (int i=0; i < ops.length(); i++) {
+      Variable *v = ops[i];
       Type *retType = v->type->asFunctionType()->retType->asRval();
       if (SC_ERROR!=getStandardConversion(NULL /*errorMsg*/, env.lang,
             SE_NONE, retType, destType)) {
@@ -1647,8 +2012,9 @@ ImplicitConversion getConversionOperator(
     // operators that] yield type 'cv2 T2 &', where 'cv1 T' is
     // reference-compatible (8.5.3) with 'cv2 T2', are
     // candidate functions."
-    SFOREACH_OBJLIST_NC(Variable, ops, iter) {
-      Variable *v = iter.data();
+    srcClass->getConversionOperators(ops, COK_REFERENCE);
+    for (int i=0; i < ops.length(); i++) {
+      Variable *v = ops[i];
       Type *retType = v->type->asFunctionType()->retType;
       if (retType->isReference()) {
         retType = retType->asRval();     // strip the reference
@@ -1690,6 +2056,117 @@ ImplicitConversion getConversionOperator(
 
 
 
+// --------------------- ConversionOperatorCache -----------------------
+bool ConversionOperatorCache::Key::operator== (Key const &obj) const
+{
+  return m_srcClass == obj.m_srcClass &&
+         m_srcCV == obj.m_srcCV &&
+         m_srcIsReference == obj.m_srcIsReference &&
+         m_destAtomic == obj.m_destAtomic &&
+         m_destCV == obj.m_destCV;
+}
+
+size_t ConversionOperatorCache::KeyHash::operator() (Key const &k) const
+{
+  return (size_t)(uintptr_t)k.m_srcClass * 31 +
+         (size_t)(uintptr_t)k.m_destAtomic +
+         (((unsigned)k.m_srcCV | ((unsigned)k.m_destCV << 4))
+            >> CV_SHIFT_AMOUNT) * 2 +
+         (k.m_srcIsReference? 1 : 0);
+}
+
+
+ConversionOperatorCache::ConversionOperatorCache()
+  : m_map(),
+    m_numQueries(0),
+    m_numHits(0),
+    m_numShortCircuits(0)
+{}
+
+ConversionOperatorCache::~ConversionOperatorCache()
+{}
+
+
+STATICDEF bool ConversionOperatorCache::makeKey(Key &key,
+  Type *srcClassType, Type *destType)
+{
+  CompoundType *srcClass = srcClassType->asRval()->asCompoundType();
+  if (!srcClass->hasFinishedDefinition()) {
+    return false;
+  }
+  SFOREACH_OBJLIST(Variable, srcClass->conversionOperators, iter) {
+    if (classifyConversionType(iter.data()->type->asFunctionTypeC()->retType)
+          & COK_TEMPLATE) {
+      return false;      // might instantiate something
+    }
+  }
+
+  // scalar destination, so no class hierarchy is consulted
+  if (destType->isReference() || !destType->isCVAtomicType()) {
+    return false;
+  }
+  AtomicType const *destAtomic = destType->asCVAtomicTypeC()->atomic;
+  if (!destAtomic->isSimpleType() && !destAtomic->isEnumType()) {
+    return false;
+  }
+
+  key.m_srcClass = srcClass;
+  key.m_srcCV = srcClassType->asRval()->getCVFlags();
+  key.m_srcIsReference = srcClassType->isReference();
+  key.m_destAtomic = destAtomic;
+  key.m_destCV = destType->getCVFlags();
+  return true;
+}
+
+
+ImplicitConversion ConversionOperatorCache::get(Env &env, SourceLoc loc,
+  ErrorList * /*nullable*/ errors, Type *srcClassType, Type *destType)
+{
+  m_numQueries++;
+
+  // when reporting errors, always do the full computation
+  if (errors) {
+    return getConversionOperator_uncached(env, loc, errors,
+                                          srcClassType, destType);
+  }
+
+  // a complete class without conversion operators is easy; anything
+  // else (e.g., an uninstantiated template) takes the full path
+  CompoundType *srcClass = srcClassType->asRval()->asCompoundType();
+  if (srcClass->hasFinishedDefinition() &&
+      srcClass->conversionOperators.isEmpty()) {
+    m_numShortCircuits++;
+    return ImplicitConversion();      // IC_NONE
+  }
+
+  Key key;
+  if (!makeKey(key, srcClassType, destType)) {
+    return getConversionOperator_uncached(env, loc, errors,
+                                          srcClassType, destType);
+  }
+
+  auto it = m_map.find(key);
+  if (it != m_map.end()) {
+    m_numHits++;
+    return it->second;
+  }
+
+  ImplicitConversion ic =
+    getConversionOperator_uncached(env, loc, errors, srcClassType, destType);
+  m_map[key] = ic;
+  return ic;
+}
+
+
+void ConversionOperatorCache::printStats(ostream &os) const
+{
+  os << "conversion operator queries: " << m_numQueries << "\n"
+     << "conversion operator hits: " << m_numHits << "\n"
+     << "conversion operator short circuits: " << m_numShortCircuits << "\n";
+}
+
+
+
 // ------------------ LUB --------------------
 static CVFlags unionCV(CVFlags cv1, CVFlags cv2, bool &cvdiffers, bool toplevel)
 {
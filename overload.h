@@ -19,6 +19,9 @@
 #include "template-fwd.h"  // TemplCandidates
 #include "variable-fwd.h"  // Variable
 
+#include <chrono>          // std::chrono::steady_clock
+#include <unordered_map>   // std::unordered_map
+
 
 // debugging output support
 extern int overloadNesting;      // overload resolutions ongoing
@@ -90,6 +93,26 @@ typedef GrowArray<ArgumentInfo> ArgumentInfoArray;
 
 // information about a single overload possibility
 class Candidate {
+  NO_OBJECT_COPIES(Candidate);
+
+private:     // data
+  // number of arguments whose conversions are stored inline
+  enum { NUM_INLINE_CONVERSIONS = 4 };
+
+  // storage for 'conversions' when there are few enough arguments
+  ImplicitConversion m_inlineConversions[NUM_INLINE_CONVERSIONS];
+
+  // storage for 'conversions' otherwise
+  ImplicitConversion *m_heapConversions;     // (nullable owner)
+  int m_heapCapacity;
+
+  // likewise for 'keys'
+  unsigned char m_inlineKeys[NUM_INLINE_CONVERSIONS];
+  unsigned char *m_heapKeys;                 // (nullable owner)
+
+  // number of elements of 'conversions'
+  int m_numConversions;
+
 public:
   // the candidate itself, with its type
   Variable *var;
@@ -99,8 +122,13 @@ public:
   // candidate, then that goes here
   Variable *instFrom;
 
-  // list of conversions, one for each argument
-  GrowArray<ImplicitConversion> conversions;
+  // list of conversions, one for each argument; points at
+  // 'm_inlineConversions' or 'm_heapConversions'
+  ImplicitConversion *conversions;
+
+  // for each conversion, its 'conversionRankKey', filled in by
+  // 'computeRankKeys' just before candidates are compared
+  unsigned char *keys;
 
 public:
   // here, 'numArgs' is the number of actual arguments, *not* the
@@ -109,6 +137,15 @@ public:
   Candidate(Variable *v, Variable *instFrom, int numArgs);
   ~Candidate();
 
+  // re-initialize as if just constructed with these arguments; this
+  // lets 'CandidatePool' recycle Candidates
+  void reset(Variable *v, Variable *instFrom, int numArgs);
+
+  int numConversions() const { return m_numConversions; }
+
+  // fill in 'keys' from 'conversions'
+  void computeRankKeys();
+
   // true if one of the conversions is IC_AMBIGUOUS
   bool hasAmbigConv() const;
 
@@ -117,6 +154,27 @@ public:
 };
 
 
+// Recycles Candidates, which are created and destroyed in large
+// numbers, one batch per overload resolution.  Each Env has one.
+class CandidatePool {
+  NO_OBJECT_COPIES(CandidatePool);
+
+private:     // data
+  // Candidates available for reuse
+  ArrayStack<Candidate*> m_free;      // (owner)
+
+public:      // funcs
+  CandidatePool();
+  ~CandidatePool();
+
+  // get a Candidate as if by 'new Candidate(v, instFrom, numArgs)'
+  Candidate *alloc(Variable *v, Variable *instFrom, int numArgs);
+
+  // give 'c' back; the caller must no longer use it
+  void release(Candidate *c);
+};
+
+
 // flags to control overload resolution
 enum OverloadFlags {
   OF_NONE        = 0x00,           // nothing special
@@ -137,6 +195,56 @@ enum OverloadFlags {
 ENUM_BITWISE_OPS(OverloadFlags, OF_ALL);
 
 
+// Aggregate statistics about overload resolution, collected when
+// "-tr overloadStats" is given.  Times are inclusive, so a resolution
+// that triggers template instantiation also accounts for any
+// resolutions done by the instantiation.
+class OverloadStats {
+  NO_OBJECT_COPIES(OverloadStats);
+
+public:      // types
+  // totals for one call site or overload set
+  class Aggregate {
+  public:
+    unsigned long m_numResolutions;
+    unsigned long m_numCandidates;     // candidates considered
+    double m_seconds;
+
+  public:
+    Aggregate() : m_numResolutions(0), m_numCandidates(0), m_seconds(0) {}
+  };
+
+public:      // data
+  unsigned long m_numResolutions;
+  unsigned long m_numCandidates;       // passed to 'processCandidate'
+  unsigned long m_numViable;           // survived 'makeCandidate'
+  unsigned long m_numTemplatesDeduced; // template candidates with deduced args
+  unsigned long m_numDeductionFailures;
+  unsigned long m_numBuiltinCandidates;
+  unsigned long m_numUserConversions;  // conversions that could be user-defined
+  unsigned long m_numNoViable;         // outcomes of 'resolveCandidate'
+  unsigned long m_numAmbiguous;
+  unsigned long m_numSelected;
+  double m_seconds;
+
+  // per call site, and per overload set (named by the first candidate)
+  std::unordered_map<SourceLoc, Aggregate> m_bySite;
+  std::unordered_map<StringRef, Aggregate> m_bySet;
+
+public:      // funcs
+  OverloadStats();
+  ~OverloadStats();
+
+  // fold in one finished resolution
+  void recordResolution(SourceLoc loc, StringRef setName,
+                        unsigned long numCandidates, double seconds);
+
+  // print the totals, then the 'topN' most expensive call sites and
+  // overload sets
+  void print(ostream &os, int topN) const;
+};
+
+
 // this class implements a single overload resolution, exposing
 // a richer interface than the simple 'resolveOverload' call below
 class OverloadResolver {
@@ -158,14 +266,27 @@ public:      // data
   // an error
   bool emptyCandidatesIsOk;
 
-  // these are the "viable candidate functions" of the standard
-  ObjArrayStack<Candidate> candidates;
+  // these are the "viable candidate functions" of the standard;
+  // they are owned, but go back to 'env.candidatePool()' rather than
+  // being deleted
+  ArrayStack<Candidate*> candidates;
 
   // all candidates processed; used for error diagnosis
   ArrayStack<Variable*> origCandidates;
 
+private:     // data
+  // 'env.overloadStats()', or NULL if not collecting them
+  OverloadStats *m_stats;
+
+  // when this resolution began, if 'm_stats'
+  std::chrono::steady_clock::time_point m_startTime;
+
+  // number of 'processCandidate' calls, if 'm_stats'
+  unsigned long m_numCandidates;
+
 private:     // funcs
-  Candidate * /*owner*/ makeCandidate(Variable *var, Variable *instFrom);
+  Candidate * /*serf*/ makeCandidate(Variable *var, Variable *instFrom);
+  bool computeConversions(Candidate *c);
 
   // debugging, error diagnosis
   void printArgInfo();
@@ -251,11 +372,72 @@ Variable *resolveOverload(
 // update: use 'ct->conversionOperators' instead
 
 
+// Memo of 'getConversionOperator' results.  Only conversions from a
+// finished class without templatized conversion operators to a
+// non-reference scalar type are recorded, since nothing later in the
+// translation unit can change those answers.  Each Env has one.
+class ConversionOperatorCache {
+  NO_OBJECT_COPIES(ConversionOperatorCache);
+
+private:     // types
+  class Key {
+  public:
+    CompoundType const *m_srcClass;
+    CVFlags m_srcCV;                 // receiver cv-qualification
+    bool m_srcIsReference;           // receiver is an lvalue
+    AtomicType const *m_destAtomic;
+    CVFlags m_destCV;
+
+  public:
+    bool operator== (Key const &obj) const;
+  };
+
+  class KeyHash {
+  public:
+    size_t operator() (Key const &k) const;
+  };
+
+private:     // data
+  std::unordered_map<Key, ImplicitConversion, KeyHash> m_map;
+
+  // statistics
+  unsigned long m_numQueries;
+  unsigned long m_numHits;
+  unsigned long m_numShortCircuits;
+
+private:     // funcs
+  static bool makeKey(Key &key, Type *srcClassType, Type *destType);
+
+public:      // funcs
+  ConversionOperatorCache();
+  ~ConversionOperatorCache();
+
+  // same interface as 'getConversionOperator'
+  ImplicitConversion get(Env &env, SourceLoc loc,
+                         ErrorList * /*nullable*/ errors,
+                         Type *srcClassType, Type *destType);
+
+  void printStats(ostream &os) const;
+};
+
+
+// Pack the parts of 'ic' that 13.3.3.2 compares first (the kind of
+// conversion, per para 2, and the rank of its standard conversion,
+// per para 3) into a small integer.  See 'compareRankKeys'.
+unsigned char conversionRankKey(ImplicitConversion const &ic);
+
+// Try to decide 'compareConversions' from the rank keys alone.  If
+// they suffice, set 'choice' to what it would return and return true;
+// otherwise the full comparison is required.
+bool compareRankKeys(unsigned char left, unsigned char right, int &choice);
+
+
 // given an object of type 'srcClass', find a conversion operator
 // that will yield 'destType' (perhaps with an additional standard
 // conversion); for now, this function assumes the conversion
 // context is as in 13.3.1.{4,5,6}: copy-initialization by conversion
-// (NOTE: this does *not* try "converting constructors" of 'destType')
+// (NOTE: this does *not* try "converting constructors" of 'destType');
+// this uses 'env.conversionOperatorCache()'
 ImplicitConversion getConversionOperator(
   Env &env,
   SourceLoc loc,
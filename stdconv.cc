@@ -405,6 +405,23 @@ StandardConversion getStandardConversion
    SpecialExpr srcSpecial, Type const *src, Type const *dest,
    bool destIsReceiver)
 {
+  // Fast path for the very common case of converting between two
+  // concrete scalar types.  Failures go through the general code so
+  // that the error message (and the 'T const &' retry) are the same.
+  if (!dest->isReference()) {
+    Type const *s = src->isReference()? src->asReferenceTypeC()->atType : src;
+    if (s->isSimpleType() && dest->isSimpleType()) {
+      SimpleTypeId sid = s->asSimpleTypeC()->type;
+      SimpleTypeId did = dest->asSimpleTypeC()->type;
+      if (isConcreteSimpleType(sid) && isConcreteSimpleType(did)) {
+        StandardConversion sc = getScalarConversionInfo(sid, did).m_conv;
+        if (sc != SC_ERROR) {
+          return src->isReference()? (SC_LVAL_TO_RVAL | sc) : sc;
+        }
+      }
+    }
+  }
+
   Conversion conv(errorMsg, lang, srcSpecial, src, dest, destIsReceiver);
 
   // --------------- group 1 ----------------
@@ -865,6 +882,11 @@ bool isIntegerPromotion(AtomicType const *src, AtomicType const *dest)
   SimpleTypeId sid = srcSimple? src->asSimpleTypeC()->type : ST_ERROR;
   SimpleTypeId did = destSimple? dest->asSimpleTypeC()->type : ST_ERROR;
 
+  return isIntegerPromotion(sid, src->isEnumType(), did);
+}
+
+bool isIntegerPromotion(SimpleTypeId sid, bool srcIsEnum, SimpleTypeId did)
+{
   if (did == ST_INT ||
       did == ST_PROMOTED_INTEGRAL ||
       did == ST_PROMOTED_ARITHMETIC) {
@@ -883,7 +905,7 @@ bool isIntegerPromotion(AtomicType const *src, AtomicType const *dest)
     // paragraph 2: wchar_t/enum -> int
     // implementation choice: I assume wchar_t and all enums fit into ints
     if (sid == ST_WCHAR_T ||
-        src->isEnumType()) {
+        srcIsEnum) {
       return true;
     }
 
@@ -987,6 +1009,8 @@ void getIntegerStats(SimpleTypeId id, int &length, int &uns)
 
 // implemented below
 static SimpleTypeId uacHelper(SimpleTypeId leftId, SimpleTypeId rightId);
+static SimpleTypeId usualArithmeticConversions_uncached(
+  SimpleTypeId leftId, SimpleTypeId rightId);
 
 // C++98 section 5 para 9
 // and C99 secton 6.3.1.8 para 1
@@ -1007,6 +1031,19 @@ Type *usualArithmeticConversions(TypeFactory &tfac, Type *left, Type *right)
   if (left->isSimple(ST_FLOAT)) { return left; }
   if (right->isSimple(ST_FLOAT)) { return right; }
 
+  // common case of two concrete scalars
+  if (left->isSimpleType() && right->isSimpleType()) {
+    SimpleTypeId leftId = left->asSimpleTypeC()->type;
+    SimpleTypeId rightId = right->asSimpleTypeC()->type;
+    if (isConcreteSimpleType(leftId) && isConcreteSimpleType(rightId)) {
+      SimpleTypeId lubId =
+        getScalarConversionInfo(leftId, rightId).m_arithResult;
+      if (lubId != ST_ERROR) {
+        return makeSimpleType(tfac, lubId);
+      }
+    }
+  }
+
   // now apply integral promotions (4.5)
   SimpleTypeId leftId = applyIntegralPromotions(left);
   SimpleTypeId rightId = applyIntegralPromotions(right);
@@ -1019,6 +1056,21 @@ Type *usualArithmeticConversions(TypeFactory &tfac, Type *left, Type *right)
 }
 
 SimpleTypeId usualArithmeticConversions(SimpleTypeId leftId, SimpleTypeId rightId)
+{
+  if (isConcreteSimpleType(leftId) && isConcreteSimpleType(rightId)) {
+    SimpleTypeId lubId =
+      getScalarConversionInfo(leftId, rightId).m_arithResult;
+    if (lubId != ST_ERROR) {
+      return lubId;
+    }
+  }
+
+  return usualArithmeticConversions_uncached(leftId, rightId);
+}
+
+// the computation behind the above, also used to fill the table
+static SimpleTypeId usualArithmeticConversions_uncached(
+  SimpleTypeId leftId, SimpleTypeId rightId)
 {
   // same initial tests as above, but directly on the ids
 
@@ -1121,6 +1173,111 @@ SimpleTypeId applyIntegralPromotions(SimpleTypeId id)
 }
 
 
+// ----------------------- ScalarConversionInfo ----------------------
+// This mirrors the final part of 'getStandardConversion' (after all
+// type constructors have been stripped, and with none of them being
+// pointers), specialized to two concrete simple types.
+static StandardConversion computeScalarConversion(SimpleTypeId sid,
+                                                  SimpleTypeId did)
+{
+  if (sid == did) {
+    return SC_IDENTITY;
+  }
+
+  if (isIntegerPromotion(sid, false /*srcIsEnum*/, did)) {
+    return SC_INT_PROM;
+  }
+
+  if (sid == ST_FLOAT && did == ST_DOUBLE) {
+    return SC_FLOAT_PROM;
+  }
+
+  // see 'isIntegerNumeric' and 'isNumeric'
+  bool srcIntegerNumeric = isIntegerType(sid) || sid == ST_BOOL;
+  bool srcFloat = isFloatType(sid);
+  bool destFloat = isFloatType(did);
+  bool srcNumeric = srcIntegerNumeric || srcFloat;
+  bool destNumeric = isIntegerType(did) || did == ST_BOOL || destFloat;
+
+  if (srcNumeric && did == ST_BOOL) {
+    return SC_BOOL_CONV;
+  }
+
+  if (srcIntegerNumeric && isIntegerType(did)) {
+    return SC_INT_CONV;
+  }
+
+  if (srcFloat && destFloat) {
+    return SC_FLOAT_CONV;
+  }
+
+  if (srcNumeric && destNumeric && (srcFloat || destFloat)) {
+    return SC_FLOAT_INT_CONV;
+  }
+
+  return SC_ERROR;
+}
+
+
+// True if 'usualArithmeticConversions' is defined on 'id', i.e., it
+// would not fail an assertion in 'getIntegerStats'.
+static bool hasArithmeticConversion(SimpleTypeId id)
+{
+  switch (applyIntegralPromotions(id)) {
+    case ST_INT:
+    case ST_UNSIGNED_INT:
+    case ST_LONG_INT:
+    case ST_UNSIGNED_LONG_INT:
+    case ST_LONG_LONG:
+    case ST_UNSIGNED_LONG_LONG:
+    case ST_FLOAT:
+    case ST_DOUBLE:
+    case ST_LONG_DOUBLE:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+
+ScalarConversionInfo const &getScalarConversionInfo(SimpleTypeId src,
+                                                    SimpleTypeId dest)
+{
+  enum { N = ST_VOID+1 };     // number of concrete simple types
+  static ScalarConversionInfo table[N][N];
+  static bool initialized = false;
+
+  if (!initialized) {
+    for (int s=0; s < N; s++) {
+      for (int d=0; d < N; d++) {
+        SimpleTypeId sid = (SimpleTypeId)s;
+        SimpleTypeId did = (SimpleTypeId)d;
+        ScalarConversionInfo &info = table[s][d];
+
+        info.m_conv = computeScalarConversion(sid, did);
+
+        // 'usualArithmeticConversions' on two floating types returns
+        // the larger, but on a floating and an integral type, it
+        // returns the floating one; either way it is handled by the
+        // initial tests, which are all we need when either side is
+        // floating.
+        if (hasArithmeticConversion(sid) && hasArithmeticConversion(did)) {
+          info.m_arithResult = usualArithmeticConversions_uncached(sid, did);
+        }
+        else {
+          info.m_arithResult = ST_ERROR;
+        }
+      }
+    }
+    initialized = true;
+  }
+
+  xassert(isConcreteSimpleType(src) && isConcreteSimpleType(dest));
+  return table[src][dest];
+}
+
+
 void test_getStandardConversion(
   Env &env, SpecialExpr special, Type const *src, Type const *dest,
   int expected)
@@ -140,10 +140,32 @@ SimpleTypeId usualArithmeticConversions(SimpleTypeId leftId, SimpleTypeId rightI
 
 // C++98 4.5
 bool isIntegerPromotion(AtomicType const *src, AtomicType const *dest);
+bool isIntegerPromotion(SimpleTypeId src, bool srcIsEnum, SimpleTypeId dest);
 SimpleTypeId applyIntegralPromotions(Type *t);
 SimpleTypeId applyIntegralPromotions(SimpleTypeId id);
 
 
+// Precomputed facts about a pair of concrete simple types (those for
+// which 'isConcreteSimpleType' is true), so the common scalar cases
+// of the above functions do not have to re-derive them.
+struct ScalarConversionInfo {
+  // What 'getStandardConversion' yields for an rvalue of the first
+  // type converted to the second, ignoring cv-qualifiers (which do
+  // not matter at the top level).  An lvalue source just adds
+  // SC_LVAL_TO_RVAL.  May be SC_ERROR.
+  StandardConversion m_conv;
+
+  // 'usualArithmeticConversions' of the pair, or ST_ERROR if that is
+  // not defined for them (e.g., 'void'); callers must then use the
+  // general code.
+  SimpleTypeId m_arithResult;
+};
+
+// Look up the info for 'src' and 'dest', both concrete.
+ScalarConversionInfo const &getScalarConversionInfo(SimpleTypeId src,
+                                                    SimpleTypeId dest);
+
+
 // testing interface, for use by the type checker
 void test_getStandardConversion(
   Env &env, SpecialExpr special, Type const *src, Type const *dest,
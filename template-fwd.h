@@ -14,5 +14,7 @@ class STemplateArgument;
 class TemplCandidates;
 class XTypeDeduction;
 class DelayedFuncInst;
+class InternedSArgs;
+class TemplateArgumentListTable;
 
 #endif // ELSA_TEMPLATE_FWD_H
@@ -15,6 +15,7 @@
 #include "mtype.h"         // MType
 
 #include "save-restore.h"  // SET_RESTORE
+#include "sm-stdint.h"     // uintptr_t
 
 #include <utility>         // std::{make_pair, pair}
 
@@ -253,9 +254,11 @@ TemplateInfo::TemplateInfo(SourceLoc il, Variable *v)
     var(NULL),
     instantiationOf(NULL),
     instantiations(),
+    instantiationIndex(),
     specializationOf(NULL),
     specializations(),
     arguments(),
+    internedArguments(NULL),
     instLoc(il),
     partialInstantiationOf(NULL),
     partialInstantiations(),
@@ -280,9 +283,11 @@ TemplateInfo::TemplateInfo(TemplateInfo const &obj)
     var(NULL),                // caller must call Variable::setTemplateInfo
     instantiationOf(NULL),
     instantiations(obj.instantiations),      // suspicious... oh well
+    instantiationIndex(obj.instantiationIndex),   // follows 'instantiations'
     specializationOf(NULL),
     specializations(obj.specializations),    // also suspicious
     arguments(),                             // copied below
+    internedArguments(obj.internedArguments),
     instLoc(obj.instLoc),
     partialInstantiationOf(NULL),
     partialInstantiations(),
@@ -299,8 +304,8 @@ TemplateInfo::TemplateInfo(TemplateInfo const &obj)
   }
   inheritedParams.reverse();
 
-  // arguments
-  copyArguments(obj.arguments);
+  // arguments; being a copy, they intern to the same list as 'obj'
+  copyTemplateArgs(arguments, objToSObjListC(obj.arguments));
 
   // argumentsToPrimary
   copyTemplateArgs(argumentsToPrimary, objToSObjListC(obj.argumentsToPrimary));
@@ -401,6 +406,12 @@ void TemplateInfo::addInstantiation(Variable *inst)
 {
   addToList(inst, instantiations,
             inst->templateInfo()->instantiationOf);
+
+  // index it too, if possible; if there is already an entry, keep it,
+  // since that is what a linear search of 'instantiations' would find
+  if (InternedSArgs const *key = inst->templateInfo()->internedArguments) {
+    instantiationIndex.insert(std::make_pair(key, inst));
+  }
 }
 
 void TemplateInfo::addSpecialization(Variable *inst)
@@ -424,6 +435,12 @@ void TemplateInfo::changeToExplicitSpec()
 
   // remove myself from the primary's list of instantiations
   primary->instantiations.removeItem(this->var);
+  if (internedArguments) {
+    auto it = primary->instantiationIndex.find(internedArguments);
+    if (it != primary->instantiationIndex.end() && it->second == this->var) {
+      primary->instantiationIndex.erase(it);
+    }
+  }
   const_cast<Variable*&>(instantiationOf) = NULL;
 
   // add myself to the primary's list of explicit specs
@@ -456,6 +473,15 @@ bool TemplateInfo::isomorphicArguments(ObjList<STemplateArgument> const &list) c
   return isomorphicArgumentLists(arguments, list);
 }
 
+bool TemplateInfo::isomorphicArguments(InternedSArgs const *key,
+                                       ObjList<STemplateArgument> const &list) const
+{
+  if (key && internedArguments) {
+    return key == internedArguments;
+  }
+  return isomorphicArgumentLists(arguments, list);
+}
+
 
 bool equalArgumentLists(ObjList<STemplateArgument> const &list1,
                         ObjList<STemplateArgument> const &list2,
@@ -531,11 +557,14 @@ bool TemplateInfo::hasParametersEx(bool considerInherited) const
 }
 
 
-Variable *TemplateInfo::getSpecialization(ObjList<STemplateArgument> const &sargs)
+Variable *TemplateInfo::getSpecialization(ObjList<STemplateArgument> const &sargs,
+                                          TemplateArgumentListTable &table)
 {
+  InternedSArgs const *key = table.intern(sargs);
+
   SFOREACH_OBJLIST_NC(Variable, specializations, iter) {
     TemplateInfo *specTI = iter.data()->templateInfo();
-    if (isomorphicArgumentLists(specTI->arguments, sargs)) {
+    if (specTI->isomorphicArguments(key, sargs)) {
       return iter.data();
     }
   }
@@ -543,6 +572,16 @@ Variable *TemplateInfo::getSpecialization(ObjList<STemplateArgument> const &sarg
 }
 
 
+Variable *TemplateInfo::findInstantiationByArgs(InternedSArgs const *key) const
+{
+  auto it = instantiationIndex.find(key);
+  if (it == instantiationIndex.end()) {
+    return NULL;
+  }
+  return it->second;
+}
+
+
 bool TemplateInfo::hasSpecificParameter(Variable const *v) const
 {
   // 'params'?
@@ -559,18 +598,23 @@ bool TemplateInfo::hasSpecificParameter(Variable const *v) const
 }
 
 
-void TemplateInfo::copyArguments(ObjList<STemplateArgument> const &sargs)
+void TemplateInfo::copyArguments(ObjList<STemplateArgument> const &sargs,
+                                 TemplateArgumentListTable &table)
 {
   copyTemplateArgs(arguments, objToSObjListC(sargs));
+  reinternArguments(table);
 }
 
-void TemplateInfo::copyArguments(SObjList<STemplateArgument> const &sargs)
+void TemplateInfo::copyArguments(SObjList<STemplateArgument> const &sargs,
+                                 TemplateArgumentListTable &table)
 {
   copyTemplateArgs(arguments, sargs);
+  reinternArguments(table);
 }
 
 
-void TemplateInfo::prependArguments(ObjList<STemplateArgument> const &sargs)
+void TemplateInfo::prependArguments(ObjList<STemplateArgument> const &sargs,
+                                    TemplateArgumentListTable &table)
 {
   // save the existing arguments (if any)
   ObjList<STemplateArgument> existing;
@@ -581,6 +625,19 @@ void TemplateInfo::prependArguments(ObjList<STemplateArgument> const &sargs)
 
   // put the old ones at the end
   arguments.concat(existing);
+
+  reinternArguments(table);
+}
+
+
+void TemplateInfo::reinternArguments(TemplateArgumentListTable &table)
+{
+  if (arguments.isEmpty()) {
+    internedArguments = NULL;
+  }
+  else {
+    internedArguments = table.intern(arguments);
+  }
 }
 
 
@@ -947,6 +1004,183 @@ char const *toString(STemplateArgument::Kind k)
 }
 
 
+// ------------------ template argument interning -------------------
+InternedSArgs::InternedSArgs(SObjList<STemplateArgument> const &args,
+                             unsigned hash)
+  : m_args(),
+    m_hash(hash)
+{
+  copyTemplateArgs(const_cast<ObjList<STemplateArgument>&>(m_args), args);
+}
+
+InternedSArgs::~InternedSArgs()
+{}
+
+
+bool internableArgumentList(SObjList<STemplateArgument> const &args)
+{
+  SFOREACH_OBJLIST(STemplateArgument, args, iter) {
+    STemplateArgument const *sarg = iter.data();
+    switch (sarg->kind) {
+      default:
+        // STA_NONE, STA_DEPEXPR, STA_TEMPLATE, STA_ATOMIC
+        return false;
+
+      case STemplateArgument::STA_TYPE:
+        if (sarg->isDependent() ||
+            sarg->getType()->containsVariables()) {
+          return false;
+        }
+        break;
+
+      case STemplateArgument::STA_REFERENCE:
+        // see IMType::imatchNontypeWithVariable
+        if (sarg->getReference()->isTemplateParam()) {
+          return false;
+        }
+        break;
+
+      case STemplateArgument::STA_INT:
+      case STemplateArgument::STA_ENUMERATOR:
+      case STemplateArgument::STA_POINTER:
+      case STemplateArgument::STA_MEMBER:
+        break;
+    }
+  }
+  return true;
+}
+
+
+// Hash a concrete type such that types that MType regards as equal
+// get the same value.  Only the type constructors, and the identity
+// of the atomic types at the leaves, are considered.  In particular,
+// cv-qualifiers are ignored, since in some positions (function
+// parameters) the matcher ignores them too.
+static unsigned typeShapeHash(Type const *t)
+{
+  enum { KICK = 33 };
+
+  t = t->skipTypedefsC();
+  unsigned tag = (unsigned)t->getTag();
+
+  switch (t->getTag()) {
+    default:
+      xfailure("bad type tag");
+
+    case Type::T_ATOMIC: {
+      AtomicType const *at = t->asCVAtomicTypeC()->atomic;
+      if (at->isSimpleType() || at->isCompoundType() || at->isEnumType()) {
+        // these are compared physically
+        return (unsigned)(uintptr_t)at;
+      }
+      return tag * KICK + (unsigned)at->getTag();
+    }
+
+    case Type::T_POINTER:
+    case Type::T_REFERENCE:
+    case Type::T_ARRAY:
+    case Type::T_POINTERTOMEMBER:
+      return typeShapeHash(t->getAtType()) * KICK + tag;
+
+    case Type::T_FUNCTION: {
+      FunctionType const *ft = t->asFunctionTypeC();
+      return (typeShapeHash(ft->retType) * KICK + ft->params.count()) * KICK
+             + tag;
+    }
+  }
+}
+
+
+unsigned hashArgumentList(SObjList<STemplateArgument> const &args)
+{
+  unsigned h = 0;
+  SFOREACH_OBJLIST(STemplateArgument, args, iter) {
+    STemplateArgument const *sarg = iter.data();
+
+    unsigned a = 0;
+    switch (sarg->kind) {
+      case STemplateArgument::STA_TYPE:
+        a = typeShapeHash(sarg->getType());
+        break;
+
+      case STemplateArgument::STA_INT:
+        a = (unsigned)sarg->getInt();
+        break;
+
+      case STemplateArgument::STA_ENUMERATOR:
+      case STemplateArgument::STA_REFERENCE:
+      case STemplateArgument::STA_POINTER:
+      case STemplateArgument::STA_MEMBER:
+        a = (unsigned)(uintptr_t)sarg->value.v;
+        break;
+
+      default:
+        // not internable; just use the kind
+        break;
+    }
+
+    h = h * 31 + a * 7 + (unsigned)sarg->kind;
+  }
+  return h;
+}
+
+
+TemplateArgumentListTable::TemplateArgumentListTable()
+  : m_lists(),
+    m_numQueries(0),
+    m_numHits(0),
+    m_numRejected(0),
+    m_numCompares(0)
+{}
+
+TemplateArgumentListTable::~TemplateArgumentListTable()
+{
+  for (auto const &entry : m_lists) {
+    delete entry.second;
+  }
+}
+
+
+InternedSArgs const *TemplateArgumentListTable::intern(
+  SObjList<STemplateArgument> const &args)
+{
+  if (!internableArgumentList(args)) {
+    m_numRejected++;
+    return NULL;
+  }
+  m_numQueries++;
+
+  unsigned hash = hashArgumentList(args);
+
+  // The cast is safe because 'isomorphicArgumentLists' only reads.
+  ObjList<STemplateArgument> const &argsAsObjList =
+    reinterpret_cast<ObjList<STemplateArgument> const &>(args);
+
+  auto range = m_lists.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    m_numCompares++;
+    if (isomorphicArgumentLists(it->second->m_args, argsAsObjList)) {
+      m_numHits++;
+      return it->second;
+    }
+  }
+
+  InternedSArgs *ret = new InternedSArgs(args, hash);
+  m_lists.insert(std::make_pair(hash, ret));
+  return ret;
+}
+
+
+void TemplateArgumentListTable::printStats(ostream &os) const
+{
+  os << "template argument lists interned: " << numLists() << "\n"
+     << "template argument list intern queries: " << m_numQueries << "\n"
+     << "template argument list intern hits: " << m_numHits << "\n"
+     << "template argument list intern rejects: " << m_numRejected << "\n"
+     << "template argument list intern compares: " << m_numCompares << "\n";
+}
+
+
 // ---------------------- TemplCandidates ------------------------
 STATICDEF
 TemplCandidates::STemplateArgsCmp TemplCandidates::compareSTemplateArgs
@@ -1587,14 +1821,14 @@ bool Env::insertTemplateArgBindings_oneParamList
 
     if (param->hasFlag(DF_TYPEDEF) &&
         (!sarg || sarg->isType())) {
-      if (!sarg && !param->defaultParamType) {
+      if (!sarg && !param->getDefaultParamType()) {
         error(stringc
           << "too few template arguments to '" << baseV->name << "'");
         return false;
       }
 
       // bind the type parameter to the type argument
-      Type *t = sarg? sarg->getType() : param->defaultParamType;
+      Type *t = sarg? sarg->getType() : param->getDefaultParamType();
       Variable *binding = makeVariable(param->loc, param->name, t,
                                        DF_TYPEDEF | DF_TEMPL_PARAM | DF_BOUND_TPARAM);
       addVariableToScope(scope, binding);
@@ -2043,23 +2277,40 @@ void removeDefaultArgs(Function *func)
 
 
 // Take all of the default argument expressions in 'primary', and
-// attach clones of them to 'inst'.  Also, take note in 'instTI' of
-// how many there are, so we know which ones are instantiated and
-// which ones are uninstantiated (initially, they are all
-// uninstantiated).
-void cloneDefaultArguments(Variable *inst, TemplateInfo *instTI,
-                           Variable *primary)
+// attach them to 'inst'.  Also, take note in 'instTI' of how many
+// there are, so we know which ones are instantiated and which ones
+// are uninstantiated (initially, they are all uninstantiated).
+//
+// Most default arguments are never used by any call, so rather than
+// cloning them here, 'inst' shares the primary's expressions and
+// 'instantiateDefaultArgs' clones each one just before tchecking it.
+// That is only safe when nothing will tcheck the primary's expression
+// in place, i.e., when it is itself shared or the primary is not an
+// instantiation.  Returns the number of expressions shared.
+int cloneDefaultArguments(Variable *inst, TemplateInfo *instTI,
+                          Variable *primary)
 {
   FunctionType *instFt = inst->type->asFunctionType();
   FunctionType *primaryFt = primary->type->asFunctionType();
 
+  bool primaryIsInst = primary->isInstantiation();
+  int numShared = 0;
+
   SObjListIterNC<Variable> instParam(instFt->params);
   SObjListIterNC<Variable> primaryParam(primaryFt->params);
 
   for (; !instParam.isDone() && !primaryParam.isDone();
        instParam.adv(), primaryParam.adv()) {
-    if (primaryParam.data()->value) {
-      instParam.data()->setValue(primaryParam.data()->value->clone());
+    Variable *src = primaryParam.data();
+    if (src->value) {
+      if (!primaryIsInst || src->getSharesValue()) {
+        instParam.data()->setValue(src->value);
+        instParam.data()->setSharesValue(true);
+        numShared++;
+      }
+      else {
+        instParam.data()->setValue(src->value->clone());
+      }
       instTI->uninstantiatedDefaultArgs++;
     }
     else {
@@ -2073,6 +2324,7 @@ void cloneDefaultArguments(Variable *inst, TemplateInfo *instTI,
   }
 
   xassert(instParam.isDone() && primaryParam.isDone());
+  return numShared;
 }
 
 
@@ -2122,11 +2374,11 @@ void syncDefaultArgsWithDefinition(Variable *instV, TemplateInfo *instTI)
   //
   #if 0      // disabled; see comments above
 
-  if (!instV->funcDefn || !instTI->instantiateBody) {
+  if (!instV->getFuncDefn() || !instTI->instantiateBody) {
     return;
   }
 
-  D_func *dfunc = getD_func(instV->funcDefn);
+  D_func *dfunc = getD_func(instV->getFuncDefn());
 
   // Iterate over both parameter lists (syntactic and semantic).  The
   // receiver is skipped because it is never syntatcially present.
@@ -2266,8 +2518,8 @@ void Env::instantiateDefaultArgs(Variable *instV, int neededDefaults)
   // we don't get those from the declarator (that is in fact a
   // mistake of the current implementation; eventually, we should
   // 'pushDeclarationScopes' regardless of DF_INLINE_DEFN)
-  bool inlineDefn = instV->funcDefn &&
-                    (instV->funcDefn->dflags & DF_INLINE_DEFN);
+  bool inlineDefn = instV->getFuncDefn() &&
+                    (instV->getFuncDefn()->dflags & DF_INLINE_DEFN);
   if (inlineDefn) {
     pushDeclarationScopes(instV, declScope);
   }
@@ -2280,6 +2532,11 @@ void Env::instantiateDefaultArgs(Variable *instV, int neededDefaults)
       // this dance is necessary because Variable::value is const,
       // forcing updates to go through setValue
       Expression *tmp = param->value;
+      if (param->getSharesValue()) {
+        // tcheck writes annotations, so get a private copy first
+        tmp = tmp->clone();
+        m_numDefaultArgCopies++;
+      }
       tmp->tcheck(*this, tmp);
       param->setValue(tmp);
 
@@ -2377,7 +2634,7 @@ Variable *Env::instantiateFunctionTemplate
 
   // annotate it with information about its templateness
   TemplateInfo *instTI = new TemplateInfo(loc, inst);
-  instTI->copyArguments(sargs);
+  instTI->copyArguments(sargs, tfac.templateArgumentLists());
 
   // insert into the instantiation list of the primary
   primaryTI->addInstantiation(inst);
@@ -2385,8 +2642,8 @@ Variable *Env::instantiateFunctionTemplate
   // this is an instantiation
   xassert(instTI->isInstantiation());
 
-  // clone default argument expressions from the primary
-  cloneDefaultArguments(inst, instTI, primary);
+  // share default argument expressions with the primary
+  m_numSharedDefaultArgs += cloneDefaultArguments(inst, instTI, primary);
 
   return inst;
 }
@@ -2441,7 +2698,7 @@ void Env::ensureFuncBodyTChecked(Variable *instV)
   }
 
   // have we seen a definition of it?
-  if (!baseV->funcDefn) {
+  if (!baseV->getFuncDefn()) {
     // nope, nothing we can do yet
     TRACE("template", "want to instantiate func body: " <<
                       instV->toQualifiedString() <<
@@ -2491,18 +2748,18 @@ void Env::instantiateFunctionBodyNow(Variable *instV, SourceLoc loc)
   Scope *defnScope;
 
   // do we have a function definition already?
-  if (instV->funcDefn) {
+  if (instV->getFuncDefn()) {
     // inline definition
     defnScope = instTI->defnScope;
   }
   else {
     // out-of-line definition; must clone the primary's definition
-    instV->funcDefn = baseV->funcDefn->clone();
+    instV->setFuncDefn(baseV->getFuncDefn()->clone());
     defnScope = baseV->templateInfo()->defnScope;
   }
 
   // remove default argument expressions from the clone parameters
-  removeDefaultArgs(instV->funcDefn);
+  removeDefaultArgs(instV->getFuncDefn());
 
   // set up the scopes in a way similar to how it was when the
   // template definition was first seen
@@ -2518,12 +2775,12 @@ void Env::instantiateFunctionBodyNow(Variable *instV, SourceLoc loc)
   // we don't get those from the declarator (that is in fact a
   // mistake of the current implementation; eventually, we should
   // 'pushDeclarationScopes' regardless of DF_INLINE_DEFN)
-  if (instV->funcDefn->dflags & DF_INLINE_DEFN) {
+  if (instV->getFuncDefn()->dflags & DF_INLINE_DEFN) {
     pushDeclarationScopes(instV, defnScope);
   }
 
   // check the body, forcing it to use 'instV'
-  instV->funcDefn->tcheck(*this, instV);
+  instV->getFuncDefn()->tcheck(*this, instV);
 
   // if we have already tcheck'd some default args, e.g., because we
   // saw uses of the template before seeing the definition, transfer
@@ -2533,7 +2790,7 @@ void Env::instantiateFunctionBodyNow(Variable *instV, SourceLoc loc)
   // remove the template argument scopes
   deleteTemplateArgBindings();
 
-  if (instV->funcDefn->dflags & DF_INLINE_DEFN) {
+  if (instV->getFuncDefn()->dflags & DF_INLINE_DEFN) {
     popDeclarationScopes(instV, defnScope);
   }
 
@@ -2688,7 +2945,8 @@ Variable *Env::instantiateClassTemplate
   TemplateInfo *instTI = new TemplateInfo(loc, inst);
 
   // fill in its arguments
-  instTI->copyArguments(spec==primary? primaryArgs : partialSpecArgs);
+  instTI->copyArguments(spec==primary? primaryArgs : partialSpecArgs,
+                        tfac.templateArgumentLists());
 
   // if it is an instance of a partial spec, keep the primaryArgs too ...
   if (spec!=primary) {
@@ -2953,17 +3211,17 @@ STemplateArgument *Env::makeDefaultTemplateArgument
 {
   // type parameter?
   if (param->hasFlag(DF_TYPEDEF) &&
-      param->defaultParamType) {
-    // use 'param->defaultParamType', but push it through the map
+      param->getDefaultParamType()) {
+    // use 'param->getDefaultParamType()', but push it through the map
     // so it can refer to previous arguments
     try {
-      Type *t = applyArgumentMapToType(map, param->defaultParamType);
+      Type *t = applyArgumentMapToType(map, param->getDefaultParamType());
       return new STemplateArgument(t);
     }
     catch (XTypeDeduction &x) {
       HANDLER();
       error(stringc << "could not evaluate default argument '"
-                    << param->defaultParamType->toString()
+                    << param->getDefaultParamType()->toString()
                     << "': " << x.why());
       return NULL;
     }
@@ -3248,7 +3506,7 @@ void Env::transferTemplateMemberInfo
 
         // arg.. I keep pushing this around.. maybe new strategy:
         // set defnScope and funcDefn at same time?
-        destVar->funcDefn = destIter.data()->asMR_func()->f;
+        destVar->setFuncDefn(destIter.data()->asMR_func()->f);
       }
       else {
         // this happens when 'destVar' is actually a partial instantiation,
@@ -3389,7 +3647,7 @@ void Env::transferTemplateMemberInfo_one
   TemplateInfo *destTI = new TemplateInfo(instLoc);
 
   // copy arguments into 'destTI'
-  destTI->copyArguments(sargs);
+  destTI->copyArguments(sargs, tfac.templateArgumentLists());
 
   // attach 'destTI' to 'destVar'
   destVar->setTemplateInfo(destTI);
@@ -3431,18 +3689,18 @@ void Env::transferTemplateMemberInfo_membert
   // might be a partial instantiation (and therefore already has some
   // arguments), and we want 'sargs' to be regarded as the arguments to
   // its containing template
-  destTI->prependArguments(sargs);
+  destTI->prependArguments(sargs, tfac.templateArgumentLists());
 
   srcTI->addPartialInstantiation(destVar);
 
   // should not have already checked this member's body even if
   // it has an inline definition
-  xassert(!destVar->funcDefn);
+  xassert(!destVar->getFuncDefn());
 
   // does the source have a definition?
-  if (srcVar->funcDefn) {
+  if (srcVar->getFuncDefn()) {
     // give the definition to the dest too
-    destVar->funcDefn = srcVar->funcDefn;
+    destVar->setFuncDefn(srcVar->getFuncDefn());
 
     // is it inline?
     if (srcVar->m_containingScope == srcTI->defnScope) {
@@ -3705,7 +3963,7 @@ bool Env::mergeParameterLists(Variable *prior,
 
       // copy a few other fields, including default value
       v->setValue(dest->value);
-      v->defaultParamType = dest->defaultParamType;
+      v->setDefaultParamType(dest->getDefaultParamType());
       v->m_containingScope = dest->m_containingScope;
       v->setScopeKind(dest->getScopeKind());
 
@@ -4345,9 +4603,11 @@ Type *Env::applyArgumentMapToType_helper(MType &map, Type *origSrc)
 Variable *Env::findCompleteSpecialization(TemplateInfo *tinfo,
                                           ObjList<STemplateArgument> const &sargs)
 {
+  InternedSArgs const *key = tfac.templateArgumentLists().intern(sargs);
+
   SFOREACH_OBJLIST_NC(Variable, tinfo->specializations, iter) {
     TemplateInfo *instTI = iter.data()->templateInfo();
-    if (instTI->isomorphicArguments(sargs)) {
+    if (instTI->isomorphicArguments(key, sargs)) {
       return iter.data();      // found it
     }
   }
@@ -4363,6 +4623,15 @@ Variable *Env::findInstantiation(TemplateInfo *tinfo,
     return tinfo->var;
   }
 
+  // Concrete argument lists can be found in the index.  Every
+  // instantiation with concrete arguments is indexed, and a concrete
+  // list cannot be isomorphic to one that is not concrete, so if it
+  // is not in the index then it is not anywhere.
+  if (InternedSArgs const *key =
+        tfac.templateArgumentLists().intern(sargs)) {
+    return tinfo->findInstantiationByArgs(key);
+  }
+
   SFOREACH_OBJLIST_NC(Variable, tinfo->instantiations, iter) {
     TemplateInfo *instTI = iter.data()->templateInfo();
     if (instTI->isomorphicArguments(sargs)) {
@@ -4602,7 +4871,8 @@ Variable *Env::makeExplicitFunctionSpecialization
       SObjList<STemplateArgument> const &serfSpecArgs = objToSObjListC(specArgs);
 
       // do we already have a specialization like this?
-      ret = primary->templateInfo()->getSpecialization(specArgs);
+      ret = primary->templateInfo()->getSpecialization(specArgs,
+              tfac.templateArgumentLists());
       if (ret) {
         TRACE("template", "re-declaration of function specialization of " <<
                           primary->type->toCString(primary->fullyQualifiedName0()) <<
@@ -4671,7 +4941,7 @@ Variable *Env::makeSpecializationVariable
 
   // make & attach the TemplateInfo
   TemplateInfo *ti = new TemplateInfo(loc, spec);
-  ti->copyArguments(args);
+  ti->copyArguments(args, tfac.templateArgumentLists());
 
   // attach to the template
   templ->templateInfo()->addSpecialization(spec);
@@ -4949,7 +5219,7 @@ bool TemplateInfo::matchesPI(CompoundType *otherPrimary,
 
 bool TemplateInfo::instantiatedFunctionBody() const
 {
-  return var->funcDefn && !var->funcDefn->instButNotTchecked();
+  return var->getFuncDefn() && !var->getFuncDefn()->instButNotTchecked();
 }
 
 
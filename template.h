@@ -18,9 +18,17 @@
 // elsa
 #include "cc-type.h"                   // Type, etc.
 
+// smbase
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
+#include "sm-ostream.h"                // ostream
+
+// libc++
+#include <unordered_map>               // std::unordered_{map,multimap}
+
 
 // used for (abstract) template parameter types
-class TypeVariable : public NamedAtomicType {
+class TypeVariable : public NamedAtomicType,
+                     private LiveCount<TypeVariable> {
 public:
   TypeVariable(StringRef name) : NamedAtomicType(name) {}
   ~TypeVariable();
@@ -46,7 +54,8 @@ public:
 // actually it might not contain type variables but instead only
 // contain non-type argument variables; the point is we don't have
 // enough information to do a concrete instantiation
-class PseudoInstantiation : public NamedAtomicType {
+class PseudoInstantiation : public NamedAtomicType,
+                            private LiveCount<PseudoInstantiation> {
 public:      // data
   // class template primary to which we are adding arguments
   CompoundType *primary;
@@ -71,7 +80,8 @@ public:      // funcs
 // dependent-typed qualifier and therefore cannot be represented
 // as an ordinary TypeVariable or PseudoInstantiation.  For
 // example, T::foo where T is a template parameter.
-class DependentQType : public NamedAtomicType {
+class DependentQType : public NamedAtomicType,
+                      private LiveCount<DependentQType> {
 public:      // data
   // The first component is either a template parameter (e.g., T::foo)
   // or is a PseudoInstantiation (e.g., C<T>::foo).  The latter could
@@ -165,7 +175,8 @@ enum TemplateThingKind {
 
 // for a template function or class, including instantiations thereof,
 // this is the information regarding its template-ness
-class TemplateInfo : public TemplateParams {
+class TemplateInfo : public TemplateParams,
+                     private LiveCount<TemplateInfo> {
 public:    // data
   // This class maintains a number of bidirectional relationships.
   // To help ensure that both ends of the relation are maintained,
@@ -192,6 +203,10 @@ public:    // data
   // inverse of 'instantiatedFrom'
   SObjList<Variable> instantiations;
 
+  // index of the elements of 'instantiations' that have non-NULL
+  // 'internedArguments', keyed by those; see 'findInstantiationByArgs'
+  std::unordered_map<InternedSArgs const *, Variable *> instantiationIndex;
+
   // the primary that this is a specialization of
   Variable * const specializationOf;       // (serf)
 
@@ -200,8 +215,21 @@ public:    // data
 
   // arguments to apply to my parent's parameters (inherited, then
   // main) to arrive at this object
+  //
+  // This should only be modified via 'copyArguments' and
+  // 'prependArguments', since they also maintain 'internedArguments'.
   ObjList<STemplateArgument> arguments;
 
+  // If 'arguments' is concrete, this is its canonical representative
+  // in the TemplateArgumentListTable, so two TemplateInfos with
+  // non-NULL 'internedArguments' have isomorphic arguments iff these
+  // pointers are equal.  NULL if 'arguments' is empty or not concrete.
+  //
+  // This speeds up lookups but does not save memory: 'arguments' is
+  // still this object's own copy, and the table keeps one more copy
+  // of each distinct list.
+  InternedSArgs const *internedArguments;      // (nullable serf)
+
   // one of three conditions holds:
   //
   // TTKind              instantiatedFrom  specializationOf  arguments
@@ -363,8 +391,21 @@ public:      // funcs
 
   // if one of my explicit specializations has arguments that
   // exactly match 'sargs' (which is a list of concrete arguments),
-  // return it; otherwise return NULL
-  Variable *getSpecialization(ObjList<STemplateArgument> const &sargs);
+  // return it; otherwise return NULL; 'table' is the one my
+  // arguments were interned in
+  Variable *getSpecialization(ObjList<STemplateArgument> const &sargs,
+                              TemplateArgumentListTable &table);
+
+  // Look up 'key' in 'instantiationIndex'.  Since every instantiation
+  // with concrete arguments is indexed, a NULL return means there is
+  // no instantiation with arguments isomorphic to 'key'.
+  Variable *findInstantiationByArgs(InternedSArgs const *key) const;
+
+  // true if my arguments are isomorphic to 'list'; 'key' is the
+  // interned version of 'list', or NULL if it is not internable, and
+  // allows a pointer comparison instead of a structural one
+  bool isomorphicArguments(InternedSArgs const *key,
+                           ObjList<STemplateArgument> const &list) const;
 
   // true if the given Variable is among the parameters (at any level)
   //
@@ -372,12 +413,19 @@ public:      // funcs
   bool hasSpecificParameter(Variable const *v) const;
 
   // copy 'sargs' into 'arguments'; the latter must be empty
-  // to begin with
-  void copyArguments(ObjList<STemplateArgument> const &sargs);
-  void copyArguments(SObjList<STemplateArgument> const &sargs);
+  // to begin with; 'table' is used to intern the result, and must be
+  // the same for all TemplateInfos whose arguments are compared
+  void copyArguments(ObjList<STemplateArgument> const &sargs,
+                     TemplateArgumentListTable &table);
+  void copyArguments(SObjList<STemplateArgument> const &sargs,
+                     TemplateArgumentListTable &table);
 
   // prepend 'sargs' onto 'arguments'
-  void prependArguments(ObjList<STemplateArgument> const &sargs);
+  void prependArguments(ObjList<STemplateArgument> const &sargs,
+                        TemplateArgumentListTable &table);
+
+  // recompute 'internedArguments' after 'arguments' has changed
+  void reinternArguments(TemplateArgumentListTable &table);
 
   // debugging/error messages: print the fully qualified name,
   // plus arguments/parameters, to identify this template thing
@@ -404,7 +452,7 @@ public:      // funcs
 // breaks the argument down into the cases described in C++98 14.3.2
 // para 1, plus types, minus template parameters, then grouped into
 // equivalence classes as implied by C++98 14.4 para 1
-class STemplateArgument {
+class STemplateArgument : private LiveCount<STemplateArgument> {
 public:
   enum Kind {
     STA_NONE,        // not yet resolved into a valid template argument
@@ -524,6 +572,81 @@ bool equalArgumentLists(ObjList<STemplateArgument> const &list1,
 char const *toString(STemplateArgument::Kind k);
 
 
+// ------------------ template argument interning -------------------
+// A concrete template argument list that has been entered into the
+// TemplateArgumentListTable.  There is exactly one of these for each
+// distinct (up to isomorphism) list, so interned lists can be compared
+// by comparing pointers.  Once created, these are never modified, and
+// are deallocated along with their table.
+class InternedSArgs {
+  NO_OBJECT_COPIES(InternedSArgs);
+
+public:      // data
+  // The arguments themselves (a private copy).
+  ObjList<STemplateArgument> const m_args;
+
+  // Hash of 'm_args', as computed by 'hashArgumentList'.
+  unsigned const m_hash;
+
+public:      // funcs
+  InternedSArgs(SObjList<STemplateArgument> const &args, unsigned hash);
+  ~InternedSArgs();
+};
+
+
+// True if 'args' can be interned.  That requires that every argument
+// be resolved and that none of them contain template parameters or
+// dependent expressions, since lists that do can be isomorphic without
+// being equal.
+bool internableArgumentList(SObjList<STemplateArgument> const &args);
+
+// Hash 'args'.  Isomorphic lists get the same hash.  The hash is
+// deliberately coarse in places where isomorphism is looser than
+// physical equality (e.g., cv-qualifiers of function parameters).
+unsigned hashArgumentList(SObjList<STemplateArgument> const &args);
+
+
+// Set of the interned template argument lists of one translation
+// unit.  Interned lists refer to Types, so each TypeFactory owns one
+// of these (see TypeFactory::templateArgumentLists), and it dies with
+// the types it refers to.
+class TemplateArgumentListTable {
+  NO_OBJECT_COPIES(TemplateArgumentListTable);
+
+private:     // data
+  // Map from hash to every interned list with that hash.  The table
+  // owns the InternedSArgs objects.
+  std::unordered_multimap<unsigned, InternedSArgs*> m_lists;
+
+  // Number of calls to 'intern' with an internable list, and the
+  // number of those that found an existing entry.
+  unsigned long m_numQueries;
+  unsigned long m_numHits;
+
+  // Number of calls to 'intern' with a list that was not internable.
+  unsigned long m_numRejected;
+
+  // Number of isomorphism checks done to resolve hash collisions.
+  unsigned long m_numCompares;
+
+public:      // funcs
+  TemplateArgumentListTable();
+  ~TemplateArgumentListTable();
+
+  // Return the canonical representative of 'args', creating it if
+  // necessary.  Return NULL if '!internableArgumentList(args)'.
+  InternedSArgs const *intern(SObjList<STemplateArgument> const &args);
+  InternedSArgs const *intern(ObjList<STemplateArgument> const &args)
+    { return intern(objToSObjListC(args)); }
+
+  // Number of distinct lists.
+  int numLists() const { return (int)m_lists.size(); }
+
+  // Print usage statistics, one per line.
+  void printStats(ostream &os) const;
+};
+
+
 // holder for the CompoundType template candidates
 class TemplCandidates {
 private:     // types
@@ -0,0 +1,99 @@
+// typed-pool.h
+// TypedPool<T>, a typed arena.
+
+#ifndef ELSA_TYPED_POOL_H
+#define ELSA_TYPED_POOL_H
+
+// smbase
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
+#include "sm-stdint.h"                 // uint32_t
+#include "xassert.h"                   // xassert
+
+// libc++
+#include <new>                         // placement new
+#include <vector>                      // std::vector
+
+
+// Allocates objects of type T in large chunks, so each object costs
+// exactly sizeof(T) (no per-allocation malloc header), and objects
+// made consecutively are adjacent in memory.
+//
+// Objects cannot be freed individually; they are all destroyed, in
+// allocation order, when the pool is.
+template <class T, unsigned CHUNK_SIZE = 1024>
+class TypedPool {
+  NO_OBJECT_COPIES(TypedPool);
+
+private:     // types
+  struct Chunk {
+    alignas(T) unsigned char m_storage[CHUNK_SIZE * sizeof(T)];
+
+    T *slot(unsigned i)
+      { return reinterpret_cast<T*>(m_storage + i*sizeof(T)); }
+  };
+
+private:     // data
+  // All chunks, in allocation order.
+  std::vector<Chunk*> m_chunks;
+
+  // Number of slots holding constructed objects in the last chunk.
+  unsigned m_usedInLast;
+
+  // Total number of objects allocated.
+  uint32_t m_numObjects;
+
+public:      // funcs
+  TypedPool()
+    : m_chunks(),
+      m_usedInLast(0),
+      m_numObjects(0)
+  {}
+
+  ~TypedPool()
+  {
+    for (size_t c=0; c < m_chunks.size(); c++) {
+      unsigned n = (c+1 == m_chunks.size())? m_usedInLast : CHUNK_SIZE;
+      for (unsigned i=0; i < n; i++) {
+        m_chunks[c]->slot(i)->~T();
+      }
+      delete m_chunks[c];
+    }
+  }
+
+  // Allocation is two steps so that classes whose constructors are
+  // only accessible to a factory can live in a pool:
+  //
+  //   T *obj = pool.commit(new (pool.reserve()) T(...));
+  //
+  // 'reserve' returns storage for the next object without claiming
+  // it, so if the constructor throws, nothing is leaked and the
+  // destructor will not run on a partially built object.
+  void *reserve()
+  {
+    if (m_chunks.empty() || m_usedInLast == CHUNK_SIZE) {
+      m_chunks.push_back(new Chunk);
+      m_usedInLast = 0;
+    }
+    return m_chunks.back()->slot(m_usedInLast);
+  }
+
+  // Claim the slot most recently returned by 'reserve', which 'obj'
+  // must now occupy.
+  T *commit(T *obj)
+  {
+    xassert(obj == m_chunks.back()->slot(m_usedInLast));
+    m_usedInLast++;
+    m_numObjects++;
+    return obj;
+  }
+
+  // Number of objects allocated so far.
+  uint32_t size() const { return m_numObjects; }
+
+  // Bytes reserved for object storage.
+  size_t bytesReserved() const
+    { return m_chunks.size() * sizeof(Chunk); }
+};
+
+
+#endif // ELSA_TYPED_POOL_H
@@ -0,0 +1,157 @@
+// typed-pool_test.cc
+// test program for TypedPool.
+
+#include "typed-pool.h"                // module under test
+
+// smbase
+#include "exc.h"                       // xassert
+#include "sm-iostream.h"               // cout
+
+// libc++
+#include <vector>                      // std::vector
+
+
+// Ids of 'Obj's in the order they were destroyed.
+static std::vector<int> destroyed;
+
+// Number of 'Obj's currently constructed.
+static int live = 0;
+
+// An object that records its lifetime, and whose constructor can be
+// made to throw.
+class Obj {
+public:
+  int m_id;
+  double m_payload;          // needs 8-byte alignment
+
+  explicit Obj(int id, bool fail = false)
+    : m_id(id),
+      m_payload(id)
+  {
+    if (fail) {
+      throw xBase("constructor failed");
+    }
+    live++;
+  }
+
+  ~Obj()
+  {
+    destroyed.push_back(m_id);
+    live--;
+  }
+};
+
+
+enum { CHUNK = 4 };
+typedef TypedPool<Obj, CHUNK> Pool;
+
+
+static Obj *make(Pool &pool, int id)
+{
+  return pool.commit(new (pool.reserve()) Obj(id));
+}
+
+
+// Objects span several chunks, are adjacent within a chunk, and are
+// destroyed in allocation order.
+static void testAllocation()
+{
+  destroyed.clear();
+  {
+    Pool pool;
+    xassert(pool.size() == 0);
+    xassert(pool.bytesReserved() == 0);
+
+    std::vector<Obj*> objs;
+    for (int i=0; i < 10; i++) {
+      objs.push_back(make(pool, i));
+      xassert(pool.size() == (uint32_t)(i+1));
+    }
+    xassert(live == 10);
+
+    // 10 objects in chunks of 4 is 3 chunks
+    xassert(pool.bytesReserved() == 3 * CHUNK * sizeof(Obj));
+
+    for (int i=0; i < 10; i++) {
+      xassert(objs[i]->m_id == i);
+      xassert((size_t)objs[i] % alignof(Obj) == 0);
+      if (i % CHUNK != 0) {
+        xassert(objs[i] == objs[i-1] + 1);
+      }
+    }
+
+    xassert(destroyed.empty());
+  }
+  xassert(live == 0);
+
+  xassert(destroyed.size() == 10);
+  for (int i=0; i < 10; i++) {
+    xassert(destroyed[i] == i);
+  }
+}
+
+
+// A constructor that throws leaves nothing to destroy, and the slot
+// is reused, including when it was the first slot of a new chunk.
+static void testThrowingConstructor()
+{
+  destroyed.clear();
+  {
+    Pool pool;
+
+    for (int i=0; i < 8; i++) {
+      if (i == 2 || i == 4) {
+        // fail once in the middle of a chunk, and once at the start
+        // of the second one
+        void *slot = pool.reserve();
+        try {
+          new (slot) Obj(100+i, true /*fail*/);
+          xfailure("should have thrown");
+        }
+        catch (xBase &) {}
+        xassert(pool.reserve() == slot);
+      }
+      make(pool, i);
+    }
+
+    xassert(pool.size() == 8);
+    xassert(live == 8);
+    xassert(pool.bytesReserved() == 2 * CHUNK * sizeof(Obj));
+  }
+  xassert(live == 0);
+
+  xassert(destroyed.size() == 8);
+  for (int i=0; i < 8; i++) {
+    xassert(destroyed[i] == i);
+  }
+
+  // a pool whose last chunk was reserved but never used
+  destroyed.clear();
+  {
+    Pool pool;
+    for (int i=0; i < CHUNK; i++) {
+      make(pool, i);
+    }
+    try {
+      new (pool.reserve()) Obj(-1, true /*fail*/);
+    }
+    catch (xBase &) {}
+    xassert(pool.size() == CHUNK);
+  }
+  xassert(live == 0);
+  xassert(destroyed.size() == CHUNK);
+}
+
+
+int main()
+{
+  testAllocation();
+  testThrowingConstructor();
+
+  cout << "typed-pool_test: PASS.\n"
+       << flush;
+  return 0;
+}
+
+
+// EOF
@@ -5,6 +5,9 @@
 #include "template.h"      // Type, TemplateInfo, etc.
 #include "trace.h"         // tracingSys
 #include "mangle.h"        // mangle()
+#include "line-table.h"    // LineTable
+#include "hashtbl.h"       // lcprngTwoSteps
+#include "sm-stdint.h"     // uintptr_t
 
 
 // dsw: need this for Oink; we'll figure out how to make this non-global later
@@ -64,22 +67,43 @@ bool SomeTypeVarNotInTemplParams_Pred::operator() (Type const *t)
 };
 
 size_t Variable::numVariables = 0;
+size_t Variable::numColdFields = 0;
+size_t const Variable::sizeofColdFields = sizeof(Variable::ColdFields);
 
 // ---------------------- Variable --------------------
+Variable::ColdFields::ColdFields()
+  : defaultParamType(NULL),
+    virtuallyOverride(NULL),
+    namespaceScope(NULL),
+    templInfo(NULL),
+    funcDefn(NULL)
+{
+  #if ELSA_OBJECT_COUNTS
+    ++numColdFields;
+  #endif
+}
+
+Variable::ColdFields::~ColdFields()
+{
+  // 'templInfo' is nominally owned, but it has never been deleted
+  // here, since instantiation bookkeeping may still refer to it
+  delete virtuallyOverride;
+  #if ELSA_OBJECT_COUNTS
+    --numColdFields;
+  #endif
+}
+
+
 Variable::Variable(SourceLoc L, StringRef n, Type *t, DeclFlags f)
   : loc(L),
     name(n),
     type(t),
     flags(f),
     value(NULL),
-    defaultParamType(NULL),
-    funcDefn(NULL),
     overload(NULL),
-    virtuallyOverride(NULL),
     m_containingScope(NULL),
-    m_denotedScope(NULL),
-    usingAlias_or_parameterizedEntity(NULL),
-    templInfo(NULL)
+    m_cold(NULL),
+    usingAlias_or_parameterizedEntity(NULL)
 {
   // the first time through, do some quick tests of the
   // encodings of 'intData'
@@ -113,11 +137,24 @@ Variable::Variable(SourceLoc L, StringRef n, Type *t, DeclFlags f)
     xassert(type);
   }
 
-  ++numVariables;
+  #if ELSA_OBJECT_COUNTS
+    ++numVariables;
+  #endif
 }
 
 Variable::~Variable()
-{}
+{
+  delete m_cold;
+}
+
+
+Variable::ColdFields *Variable::getCold()
+{
+  if (!m_cold) {
+    m_cold = new ColdFields;
+  }
+  return m_cold;
+}
 
 
 void Variable::checkInvariants()
@@ -270,7 +307,7 @@ bool Variable::isUninstTemplateMember() const
 
 bool Variable::isUninstClassTemplMethod() const
 {
-  return hasFlag(DF_VIRTUAL) && type->isMethod() && isInstantiation() && !funcDefn;
+  return hasFlag(DF_VIRTUAL) && type->isMethod() && isInstantiation() && !getFuncDefn();
 }
 
 
@@ -300,29 +337,35 @@ bool Variable::isTemplateClass(bool considerInherited) const
 
 bool Variable::isInstantiation() const
 {
-  return templInfo && templInfo->isInstantiation();
+  return m_cold &&
+         m_cold->templInfo &&
+         m_cold->templInfo->isInstantiation();
 }
 
 
 TemplateInfo *Variable::templateInfo() const
 {
   // 2005-02-23: experiment: alias shares referent's template info
-  return skipAliasC()->templInfo;
+  Variable const *v = skipAliasC();
+  return v->m_cold? v->m_cold->templInfo : NULL;
 }
 
 void Variable::setTemplateInfo(TemplateInfo *templInfo0)
 {
-  templInfo = templInfo0;
+  // storing NULL does not need a ColdFields record
+  if (templInfo0 || m_cold) {
+    getCold()->templInfo = templInfo0;
+  }
 
   // 2005-03-07: this assertion fails in some error cases (e.g., error
   // 1 of in/t0434.cc); I tried a few hacks but am now giving up on it
   // entirely
-  //xassert(!(templInfo && notQuantifiedOut()));
+  //xassert(!(templInfo0 && notQuantifiedOut()));
 
   // complete the association
-  if (templInfo) {
+  if (templInfo0) {
     // I am the method allowed to change TemplateInfo::var
-    const_cast<Variable*&>(templInfo->var) = this;
+    const_cast<Variable*&>(templInfo0->var) = this;
   }
   else {
     // this happens when we're not in a template at all, but the
@@ -450,11 +493,12 @@ string Variable::fullyQualifiedName0() const
 //   }
 
   if (isNamespace()) {
-    if (m_denotedScope->isGlobalScope()) {
+    Scope *s = getDenotedScope();
+    if (s->isGlobalScope()) {
       return "::";
     }
     else {
-      return m_denotedScope->fullyQualifiedCName();
+      return s->fullyQualifiedCName();
     }
   }
 
@@ -539,7 +583,7 @@ string Variable::fullyQualifiedMangledName0() {
   // dsw: prepend with the filename if is global and static; this
   // ensures proper linking
   if (isStaticLinkage()) {
-    fqName << "file:" << sourceLocManager->getFile(loc) << ";";
+    fqName << "file:" << LineTable::global().decode(loc).m_fname << ";";
   }
 
   // quarl 2006-07-10
@@ -848,7 +892,7 @@ int Variable::getBitfieldSize() const
 Scope *Variable::getDenotedScope() const
 {
   if (isNamespace()) {
-    return m_denotedScope;
+    return m_cold? m_cold->namespaceScope : NULL;
   }
 
   if (type->isCompoundType()) {
@@ -861,9 +905,46 @@ Scope *Variable::getDenotedScope() const
 }
 
 
+void Variable::setNamespaceScope(Scope *s)
+{
+  xassert(isNamespace());
+  getCold()->namespaceScope = s;
+}
+
+
+void Variable::setFuncDefn(Function *f)
+{
+  if (f || m_cold) {
+    getCold()->funcDefn = f;
+  }
+}
+
+
+void Variable::setDefaultParamType(Type *t)
+{
+  if (t || m_cold) {
+    getCold()->defaultParamType = t;
+  }
+}
+
+
+void Variable::addVirtuallyOverride(Variable *overridden)
+{
+  ColdFields *cold = getCold();
+  if (!cold->virtuallyOverride) {
+    cold->virtuallyOverride = new SObjSet<Variable*>();
+  }
+  cold->virtuallyOverride->add(overridden);
+}
+
+
 // --------------------- OverloadSet -------------------
 OverloadSet::OverloadSet()
-  : set()
+  : set(),
+    m_members(),
+    m_table(),
+    m_tableUsed(0),
+    m_wildMembers()
 {}
 
 OverloadSet::~OverloadSet()
@@ -878,6 +959,238 @@ void OverloadSet::addMember(Variable *v)
 //    xassert(!findByType(v->type->asFunctionType()));
   xassert(v->type->isFunctionType());
   set.prepend(v);
+
+  if (!m_members.empty()) {
+    unsigned hash = 0;
+    bool wild = !signatureHash(v->type->asFunctionTypeC(), hash);
+    m_members.push_back(Member(v, hash, wild));
+    indexMember(m_members.size() - 1);
+  }
+  else if (set.count() >= INDEX_THRESHOLD) {
+    rebuildIndex();
+  }
+}
+
+
+void OverloadSet::memberTypeChanged(Variable *v)
+{
+  xassert(v->type->isFunctionType());
+  if (!m_members.empty()) {
+    rebuildIndex();
+  }
+}
+
+
+// Return the slot of 'm_table' for 'hash': the one holding the
+// newest member with that hash, or else the empty one where it would
+// go.  The table must not be empty.
+unsigned OverloadSet::findSlot(unsigned hash) const
+{
+  unsigned mask = m_table.size() - 1;
+  unsigned i = lcprngTwoSteps(hash) & mask;
+  while (m_table[i] && m_members[m_table[i]-1].m_hash != hash) {
+    i = (i+1) & mask;
+  }
+  return i;
+}
+
+
+void OverloadSet::indexMember(int index)
+{
+  Member &m = m_members[index];
+  if (m.m_wild) {
+    m_wildMembers.push_back(index);
+    return;
+  }
+
+  if ((m_tableUsed+1) * 2 > (int)m_table.size()) {
+    // grow, and re-insert the newest member of each hash
+    std::vector<int> old;
+    old.swap(m_table);
+    m_table.resize(old.empty()? 16 : old.size() * 2, 0);
+    for (int slot : old) {
+      if (slot) {
+        m_table[findSlot(m_members[slot-1].m_hash)] = slot;
+      }
+    }
+  }
+
+  unsigned i = findSlot(m.m_hash);
+  if (m_table[i]) {
+    m.m_older = m_table[i]-1;
+  }
+  else {
+    m_tableUsed++;
+  }
+  m_table[i] = index+1;
+}
+
+
+void OverloadSet::rebuildIndex()
+{
+  m_members.clear();
+  m_table.clear();
+  m_tableUsed = 0;
+  m_wildMembers.clear();
+
+  // 'set' is newest first
+  ArrayStack<Variable*> oldestFirst(set.count());
+  SFOREACH_OBJLIST_NC(Variable, set, iter) {
+    oldestFirst.push(iter.data());
+  }
+  for (int i = oldestFirst.length()-1; i >= 0; i--) {
+    Variable *v = oldestFirst[i];
+    unsigned hash = 0;
+    bool wild = !signatureHash(v->type->asFunctionTypeC(), hash);
+    m_members.push_back(Member(v, hash, wild));
+    indexMember(m_members.size() - 1);
+  }
+}
+
+
+// constants for 'paramTypeHash', in the spirit of those used by
+// Type::innerHashValue
+enum {
+  SIG_HASH_KICK = 33,
+  SIG_TAG_KICK = 7
+};
+
+// Hash 'type' for 'OverloadSet::signatureHash', ignoring all cv flags,
+// typedefs and array sizes, or return false if it has parts that can
+// match structurally different types.  The concrete atomic types only
+// match themselves (see IMType::imatchAtomicType), so their addresses
+// are hashed.
+static bool paramTypeHash(Type const *type, unsigned &hash)
+{
+  type = type->skipTypedefsC();
+  Type::Tag tag = type->getTag();
+
+  switch (tag) {
+    default: xfailure("bad type tag");
+
+    case Type::T_ATOMIC: {
+      AtomicType const *atomic = type->asCVAtomicTypeC()->atomic;
+      if (atomic->isSimpleType()) {
+        if (atomic->asSimpleTypeC()->type == ST_DEPENDENT) {
+          return false;
+        }
+      }
+      else if (!atomic->isCompoundType() && !atomic->isEnumType()) {
+        return false;          // type variable, etc.
+      }
+      hash = (unsigned)(uintptr_t)atomic;
+      return true;
+    }
+
+    case Type::T_POINTER:
+      if (!paramTypeHash(type->asPointerTypeC()->atType, hash)) {
+        return false;
+      }
+      break;
+
+    case Type::T_REFERENCE:
+      if (!paramTypeHash(type->asReferenceTypeC()->atType, hash)) {
+        return false;
+      }
+      break;
+
+    case Type::T_ARRAY:
+      if (!paramTypeHash(type->asArrayTypeC()->eltType, hash)) {
+        return false;
+      }
+      break;
+
+    case Type::T_FUNCTION:
+      // only the tag; nested function types are rare in parameters
+      if (type->containsGeneralizedDependent()) {
+        return false;
+      }
+      hash = 0;
+      break;
+
+    case Type::T_POINTERTOMEMBER: {
+      PointerToMemberType const *ptm = type->asPointerToMemberTypeC();
+      if (!ptm->inClassNAT->isCompoundType() ||
+          !paramTypeHash(ptm->atType, hash)) {
+        return false;
+      }
+      hash += (unsigned)(uintptr_t)ptm->inClassNAT;
+      break;
+    }
+  }
+
+  hash = hash * SIG_HASH_KICK + tag * SIG_TAG_KICK;
+  return true;
+}
+
+
+STATICDEF bool OverloadSet::signatureHash(FunctionType const *ft,
+                                          unsigned &hash)
+{
+  if (ft->hasFlag(FF_NO_PARAM_INFO)) {
+    return false;
+  }
+
+  SObjListIter<Variable> iter(ft->params);
+  if (ft->isMethod()) {
+    iter.adv();                // skip the receiver
+  }
+
+  hash = ft->acceptsVarargs()? 1 : 0;
+  for (; !iter.isDone(); iter.adv()) {
+    unsigned p = 0;
+    if (!paramTypeHash(iter.data()->type, p)) {
+      return false;
+    }
+    hash = hash * SIG_HASH_KICK + p;
+  }
+  return true;
+}
+
+
+OverloadSet::CandidateIter::CandidateIter(OverloadSet const &set,
+                                          FunctionType const *ft)
+  : m_set(set),
+    m_same(-1),
+    m_wild(-1),
+    m_indexed(false)
+{
+  unsigned hash;
+  if (set.m_members.empty() || !signatureHash(ft, hash)) {
+    return;
+  }
+
+  m_indexed = true;
+  m_wild = (int)set.m_wildMembers.size() - 1;
+  if (set.m_tableUsed) {
+    int slot = set.m_table[set.findSlot(hash)];
+    m_same = slot - 1;           // -1 if there is none
+  }
+}
+
+
+// index into 'm_set.m_members' of the current member: the newer of
+// the next same-hash member and the next wild one
+int OverloadSet::CandidateIter::current() const
+{
+  xassert(!isDone());
+  if (m_wild < 0) {
+    return m_same;
+  }
+  int wild = m_set.m_wildMembers[m_wild];
+  return m_same > wild? m_same : wild;
+}
+
+
+void OverloadSet::CandidateIter::adv()
+{
+  int index = current();
+  if (index == m_same) {
+    m_same = m_set.m_members[index].m_older;
+  }
+  else {
+    m_wild--;
+  }
 }
 
 
@@ -12,16 +12,22 @@
 #include "cc-scope-fwd.h"              // Scope
 #include "cc-type-fwd.h"               // Type, etc.
 #include "cc-type-visitor-fwd.h"       // TypeVisitor
+#include "live-count.h"                // LiveCount
 #include "packedword.h"                // PackedWord
 #include "template-fwd.h"              // TemplateInfo
 
 // smbase
+#include "array.h"                     // ArrayStack
 #include "serialno.h"                  // INHERIT_SERIAL_BASE
+#include "sm-macros.h"                 // NO_OBJECT_COPIES
 #include "sobjlist.h"                  // SObjList
 #include "sobjset.h"                   // SObjSet
 #include "srcloc.h"                    // SourceLoc
 #include "strtable.h"                  // StringRef
 
+// libc++
+#include <vector>                      // std::vector
+
 
 // This (after going through the string table) is used as Variable::name
 // for conversion operators.
@@ -61,7 +67,10 @@ extern char const * const specialName_constructor;
 // dependencies extensively, including the TypeFactory.  So while
 // they are (and will remain) physically separate files, they
 // should be treated as their own subsystem.
-class Variable INHERIT_SERIAL_BASE {
+class Variable INHERIT_SERIAL_BASE_AND private LiveCount<Variable> {
+  // 'm_cold' is owned, so copying would delete it twice
+  NO_OBJECT_COPIES(Variable);
+
 public:    // data
   // for now, there's only one location, and it's the definition
   // location if that exists, else the declaration location; there
@@ -85,35 +94,15 @@ public:    // data
   // if this Variable is a parameter of a template function, then this
   // 'value' might not have been tchecked; you have to look at the
   // associated TemplateInfo::uninstantiatedDefaultArgs to find out
+  // (and an untchecked one may be shared; see 'getSharesValue')
   //
   // this is const to encourage use of use setValue()
   Expression * const value;     // (nullable serf)
 
-  // default value for template parameters; see TODO at end
-  // of this file
-  Type *defaultParamType; // (nullable serf)
-
-  // associated function definition; if NULL, either this thing isn't
-  // a function or we never saw a definition
-  Function *funcDefn;     // (nullable serf)
-
   // if this name has been overloaded, then this will be a pointer
   // to the set of overloaded names; otherwise it's NULL
   OverloadSet *overload;  // (nullable serf)
 
-  // if we are a virtual method, the set of variables of other
-  // viritual methods that we immediately override; a NULL pointer
-  // here just means the empty list;
-  //
-  // NOTE: Scott: I wanted to do it in full correctness and not omit
-  // anything in the case of multiple-inheritance; however it is
-  // really hard to know what functions to omit, so I therefore do the
-  // quadratic thing and include them all; given that you do something
-  // similar with the BaseClassSubobj heriarchy for classes, I don't
-  // think this is so bad; feel free to change it; please change the
-  // name to directlyVirtuallyOverride if you do.
-  SObjSet<Variable*> *virtuallyOverride;
-
   // Named scope in which the variable appears.  This is only non-NULL
   // if the scope is a namespace, a class, or is the global scope,
   // meaning this Variable is a member of one of those.
@@ -124,16 +113,18 @@ public:    // data
   // fixed (I think).
   Scope *m_containingScope;            // (nullable serf)
 
-  // If this Variable 'isNamespace()', then this is the Scope named by
-  // this Variable.  Otherwise it is NULL.
-  //
-  // Note that multiple Variables can have the same 'm_denotedScope' due
-  // to namespace aliases.
-  Scope *m_denotedScope;               // (nullable serf)
-
-  // total number of Variables created
+  // total number of Variables created; always 0 if
+  // ELSA_OBJECT_COUNTS is 0
   static size_t numVariables;
 
+  // number of live ColdFields records, i.e., the number of Variables
+  // that needed at least one of the rarely-used fields; always 0 if
+  // ELSA_OBJECT_COUNTS is 0
+  static size_t numColdFields;
+
+  // sizeof(ColdFields), for memory accounting
+  static size_t const sizeofColdFields;
+
 private:      // data
   // The next two fields are used to store conceptually different
   // things in a single word in order to save space.  I am concerned
@@ -147,20 +138,65 @@ private:      // data
   // partition into bits
   PackedWord intData;
 
+  // Fields that only a small minority of Variables (template
+  // parameters, templates, virtual methods, namespaces, defined
+  // functions) use.  Locals, parameters and data members, which make
+  // up the bulk of all Variables, never allocate one of these, so they
+  // do not pay for the space.  All pointers here are nullable serfs
+  // except as noted.
+  struct ColdFields {
+    // default value for template parameters; see TODO at end of
+    // this file
+    Type *defaultParamType;
+
+    // if we are a virtual method, the set of variables of other
+    // viritual methods that we immediately override; a NULL pointer
+    // here just means the empty list;
+    //
+    // NOTE: Scott: I wanted to do it in full correctness and not omit
+    // anything in the case of multiple-inheritance; however it is
+    // really hard to know what functions to omit, so I therefore do
+    // the quadratic thing and include them all; given that you do
+    // something similar with the BaseClassSubobj heriarchy for
+    // classes, I don't think this is so bad; feel free to change it;
+    // please change the name to directlyVirtuallyOverride if you do.
+    SObjSet<Variable*> *virtuallyOverride;     // (owner)
+
+    // If this Variable 'isNamespace()', then this is the Scope named
+    // by this Variable.  Otherwise it is NULL.
+    //
+    // Note that multiple Variables can have the same namespace scope
+    // due to namespace aliases.
+    Scope *namespaceScope;
+
+    // for templates, this is the list of template parameters and
+    // other template stuff; for a primary it includes a list of
+    // already-instantiated versions
+    TemplateInfo *templInfo;                   // (owner)
+
+    // associated function definition; if NULL, either this thing
+    // isn't a function or we never saw a definition
+    Function *funcDefn;
+
+    ColdFields();
+    ~ColdFields();
+  };
+
+  // Rarely-used fields, or NULL if none of them has been set yet.
+  ColdFields *m_cold;                          // (nullable owner)
+
   // for most kinds of Variables, this is 'getUsingAlias()'; for
   // template parameters (isTemplateParam()), this is
   // 'getParameterizedEntity()'; if 'getIsGNUAlias()', this is
   // 'getGNUAliasTarget()'.
+  //
+  // This stays inline, rather than in 'm_cold', because 'skipAliasC'
+  // reads it on nearly every lookup.
   Variable *usingAlias_or_parameterizedEntity;   // (nullable serf)
 
-  // for templates, this is the list of template parameters and other
-  // template stuff; for a primary it includes a list of
-  // already-instantiated versions
-  //
-  // this is private to force clients to go through templateInfo(),
-  // which skips aliases, as aliases now share templateInfos with
-  // the things they are aliases of
-  TemplateInfo *templInfo;      // (owner)
+private:      // funcs
+  // Return 'm_cold', creating it if necessary.
+  ColdFields *getCold();
 
 protected:    // funcs
   friend class BasicTypeFactory;
@@ -272,13 +308,19 @@ public:
   // an alias of.
   PACKEDWORD_DEF_GS(intData, IsGNUAlias,       bool,          12, 13)
 
+  // If true, 'value' is a default argument that has not been tcheck'd
+  // for this instantiation and is shared with the corresponding
+  // parameter of the template primary, so it must be cloned before it
+  // is modified.  Cleared by 'setValue'.
+  PACKEDWORD_DEF_GS(intData, SharesValue,      bool,          13, 14)
+
   PACKEDWORD_DEF_GS(intData, ParameterOrdinal, int,           16, 32)
   // ParameterOrdinal and BitfieldSize overlap, but
   // set/getBitfieldSize check an assertion before delegating to
   // ParameterOrdinal
   // PACKEDWORD_DEF_GS(intData, BitfieldSize, int, 16, 32)
 
-  void setValue(Expression *e) { const_cast<Expression *&>(value)=e; setHasValue(e!=NULL); }
+  void setValue(Expression *e) { const_cast<Expression *&>(value)=e; setHasValue(e!=NULL); setSharesValue(false); }
 
   // true if this name refers to a template function, or is
   // the typedef-name of a template class (or partial specialization)
@@ -294,6 +336,9 @@ public:
 
   // Templates (and specializations) and instantiations have
   // TemplateInfo.  For other entities, this is NULL.
+  //
+  // This goes through 'skipAliasC()', as aliases share templateInfos
+  // with the things they are aliases of.
   TemplateInfo *templateInfo() const;
   void setTemplateInfo(TemplateInfo *templInfo0);
 
@@ -415,6 +460,27 @@ public:
   // scope, or a class); get it.
   Scope *getDenotedScope() const;
 
+  // Set the Scope this namespace Variable names.  Requires
+  // 'isNamespace()'.
+  void setNamespaceScope(Scope *s);
+
+  // Function definition of a function, or NULL if this is not a
+  // function or its definition has not been seen.
+  Function *getFuncDefn() const
+    { return m_cold? m_cold->funcDefn : NULL; }
+  void setFuncDefn(Function *f);
+
+  // Default type argument of a template type parameter, or NULL.
+  Type *getDefaultParamType() const
+    { return m_cold? m_cold->defaultParamType : NULL; }
+  void setDefaultParamType(Type *t);
+
+  // Set of virtual methods this one immediately overrides; NULL
+  // means the empty set.
+  SObjSet<Variable*> const *getVirtuallyOverride() const
+    { return m_cold? m_cold->virtuallyOverride : NULL; }
+  void addVirtuallyOverride(Variable *overridden);
+
   // dsw: Variables are part of the type system at least for purposes
   // of traversal
   void traverse(TypeVisitor &vis);
@@ -429,17 +495,100 @@ bool sameEntity(Variable const *v1, Variable const *v2);
 
 
 class OverloadSet {
-public:
-  // list-as-set
+private:     // types
+  enum {
+    // Sets with fewer members than this are just scanned.
+    INDEX_THRESHOLD = 8,
+  };
+
+  // one element of 'm_members'
+  struct Member {
+    Variable *m_var;                   // (serf) the member
+    unsigned m_hash;                   // 'signatureHash' of its type
+    bool m_wild;                       // true if it has no hash
+
+    // index of the next older non-wild member with the same hash,
+    // or -1
+    int m_older;
+
+    Member(Variable *v, unsigned h, bool w)
+      : m_var(v), m_hash(h), m_wild(w), m_older(-1) {}
+  };
+
+public:      // types
+  // Iterates over the members of a set that might be equivalent to
+  // some function type, in the same order as in 'set'.  If the set
+  // is not indexed or the type is wild, 'isIndexed()' is false, the
+  // iteration is empty, and the caller should examine all of 'set'.
+  class CandidateIter {
+  private:     // data
+    OverloadSet const &m_set;
+
+    // next member with the same hash, or -1
+    int m_same;
+
+    // position in 'm_set.m_wildMembers' of the next wild member, or -1
+    int m_wild;
+
+    bool m_indexed;
+
+  private:     // funcs
+    int current() const;
+
+  public:      // funcs
+    CandidateIter(OverloadSet const &set, FunctionType const *ft);
+
+    bool isIndexed() const { return m_indexed; }
+    bool isDone() const { return m_same < 0 && m_wild < 0; }
+    Variable *data() const { return m_set.m_members[current()].m_var; }
+    void adv();
+  };
+  friend class CandidateIter;
+
+public:      // data
+  // list-as-set, most recently added first
   SObjList<Variable> set;
 
-public:
+private:     // data
+  // The elements of 'set', oldest first, so an index into this is
+  // an insertion sequence number.  Empty until the set first has
+  // INDEX_THRESHOLD members.
+  std::vector<Member> m_members;
+
+  // Open-addressed table of the non-wild members, keyed by their
+  // hash and probed linearly.  Each slot is 0 for empty, or 1 plus
+  // the index into 'm_members' of the newest member with some hash;
+  // older ones are reached through 'Member::m_older'.  Its size is a
+  // power of 2 and at least twice the number of slots used.
+  std::vector<int> m_table;
+  int m_tableUsed;
+
+  // Indices into 'm_members' of the wild members, in increasing order.
+  std::vector<int> m_wildMembers;
+
+private:     // funcs
+  unsigned findSlot(unsigned hash) const;
+  void indexMember(int index);
+  void rebuildIndex();
+
+public:      // funcs
   OverloadSet();
   ~OverloadSet();
 
   void addMember(Variable *v);
   int count() const { return set.count(); }
 
+  // Call this after changing the 'type' of member 'v'.
+  void memberTypeChanged(Variable *v);
+
+  // Compute into 'hash' a hash of the signature of 'ft' such that two
+  // function types that Env::findInOverloadSet could regard as
+  // equivalent have the same hash.  The return type, the receiver,
+  // and all cv-qualifiers are ignored.  Return false, leaving 'hash'
+  // unspecified, if the signature has template-dependent parts or no
+  // parameter info; such a "wild" signature can match many others.
+  static bool signatureHash(FunctionType const *ft, unsigned &hash);
+
   // These are obsolete; see Env::findInOverloadSet.
   //
   // Update: But Oink wants to use them for linker imitation.. and